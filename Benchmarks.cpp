@@ -0,0 +1,416 @@
+/*
+  Filename   : Benchmarks.cpp
+  Description: UML++ model benchmarks using the Google Benchmark framework.
+  Model benchmarks run against models of 10, 1k and 100k classes, and page
+  benchmarks against a server started in this process. Build the
+  run_benchmarks target to write the results to benchmarks.json.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <benchmark/benchmark.h>
+
+#include <cli/clifilesession.h>
+#include <httplib.h>
+#include <inja/inja.hpp>
+
+#include "umllib/include/UMLCLI.hpp"
+#include "umllib/include/UMLClass.hpp"
+#include "umllib/include/UMLData.hpp"
+#include "umllib/include/UMLEmbeddedFiles.hpp"
+#include "umllib/include/UMLField.hpp"
+#include "umllib/include/UMLGenerator.hpp"
+#include "umllib/include/UMLLoadGenerator.hpp"
+#include "umllib/include/UMLMethod.hpp"
+#include "umllib/include/UMLParameter.hpp"
+#include "umllib/include/UMLServer.hpp"
+#include "umllib/include/UMLTemplateCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+//--------------------------------------------------------------------
+
+/************************************************************/
+// Models
+
+// Name of the i'th class in a benchmark model
+static std::string className (int64_t i)
+{
+  return "Class" + std::to_string (i);
+}
+
+// Model with the given number of classes. Each class has two fields and a
+// method taking one parameter, and every tenth class is the source of an
+// aggregation to the next. Built once per size, since building the larger
+// ones takes a while; benchmarks leave the model as they found it.
+static UMLData& model (int64_t size)
+{
+  static std::map<int64_t, std::unique_ptr<UMLData>> models;
+  std::unique_ptr<UMLData>& found = models[size];
+  if (!found)
+  {
+    found = std::make_unique<UMLData>();
+    for (int64_t i = 0; i < size; ++i)
+    {
+      std::string name = className (i);
+      found->addClass (name);
+      found->addClassAttribute (name, std::make_shared<UMLField> ("count", "int"));
+      found->addClassAttribute (name, std::make_shared<UMLField> ("label", "string"));
+      found->addClassAttribute (name, std::make_shared<UMLMethod> ("update", "void",
+        std::list<UMLParameter> {UMLParameter ("value", "int")}));
+    }
+    for (int64_t i = 0; i + 1 < size; i += 10)
+      found->addRelationship (className (i), className (i + 1), 0);
+  }
+  return *found;
+}
+
+// Class in the middle of the model, so finding it scans half the classes
+static std::string middleClass (int64_t size)
+{
+  return className (size / 2);
+}
+
+// Runs each benchmark at every model size, fitting how it grows with size
+#define MODEL_SIZES(function) \
+  BENCHMARK (function)->Arg (10)->Arg (1000)->Arg (100000)->Complexity()->Unit (benchmark::kMicrosecond)
+
+/************************************************************/
+// Adding
+
+static void BM_AddClass (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+  {
+    data.addClass ("Added");
+    state.PauseTiming();
+    data.deleteClass ("Added");
+    state.ResumeTiming();
+  }
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_AddClass);
+
+static void BM_AddClassAttribute (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  std::string name = middleClass (state.range (0));
+  for (auto _ : state)
+  {
+    auto field = std::make_shared<UMLField> ("added", "int");
+    data.addClassAttribute (name, field);
+    state.PauseTiming();
+    data.removeClassAttribute (name, field);
+    state.ResumeTiming();
+  }
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_AddClassAttribute);
+
+static void BM_AddParameter (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  std::string name = middleClass (state.range (0));
+  method_ptr method = std::static_pointer_cast<UMLMethod> (data.getClass (name).getAttribute ("update"));
+  for (auto _ : state)
+  {
+    data.addParameter (name, method, "added", "int");
+    state.PauseTiming();
+    data.deleteParameter (name, method, "added");
+    state.ResumeTiming();
+  }
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_AddParameter);
+
+// Classes 1 and 2 are never related in the benchmark models
+static void BM_AddRelationship (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+  {
+    data.addRelationship (className (1), className (2), 1);
+    state.PauseTiming();
+    data.deleteRelationship (className (1), className (2));
+    state.ResumeTiming();
+  }
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_AddRelationship);
+
+/************************************************************/
+// Changing and deleting
+
+static void BM_DeleteClass (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    data.addClass ("Added");
+    state.ResumeTiming();
+    data.deleteClass ("Added");
+  }
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_DeleteClass);
+
+// Renames back and forth, so every iteration is a rename
+static void BM_ChangeClassName (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  std::string names[] = {middleClass (state.range (0)), "Renamed"};
+  int current = 0;
+  for (auto _ : state)
+  {
+    data.changeClassName (names[current], names[1 - current]);
+    current = 1 - current;
+  }
+  if (current)
+    data.changeClassName (names[1], names[0]);
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_ChangeClassName);
+
+/************************************************************/
+// Reading
+
+static void BM_GetJson (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize (data.getJson());
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_GetJson);
+
+// Completes the first page of class names sharing a prefix with many
+static void BM_CompleteClassName (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize (data.getNameIndex().complete (UMLNameKind::className, "Class5"));
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_CompleteClassName);
+
+// Reads the model's memory footprint, which should cost the same at any size
+static void BM_Footprint (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize (data.getFootprint().getTotalBytes());
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_Footprint);
+
+// checkAttribute only looks within one class, so this one is sized by the
+// class's attribute count rather than the model's class count. The field
+// checked for isn't there, so every attribute is compared.
+static void BM_CheckAttribute (benchmark::State& state)
+{
+  UMLClass uclass ("Checked");
+  for (int64_t i = 0; i < state.range (0); ++i)
+    uclass.addAttribute (std::make_shared<UMLField> ("field" + std::to_string (i), "int"));
+  auto missing = std::make_shared<UMLField> ("missing", "int");
+  for (auto _ : state)
+    benchmark::DoNotOptimize (uclass.checkAttribute (missing));
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_CheckAttribute);
+
+/************************************************************/
+// Displaying through the CLI
+
+// Command line interface loaded with a generated model. The model goes
+// through a save file, the same way a user would open a large diagram.
+static UMLCLI& cliModel (const UMLGeneratorOptions& options)
+{
+  static std::map<std::pair<size_t, size_t>, std::unique_ptr<UMLCLI>> clis;
+  std::unique_ptr<UMLCLI>& found = clis[{options.classes, options.maxMethods}];
+  if (!found)
+  {
+    std::string name = "benchmark_" + std::to_string (options.classes) + "_" + std::to_string (options.maxMethods);
+    {
+      std::ofstream file (name + ".json");
+      UMLGenerator (options).write (file);
+    }
+    found = std::make_unique<UMLCLI>();
+    std::ostringstream discard;
+    std::streambuf* previous = std::cout.rdbuf (discard.rdbuf());
+    found->load_uml (name);
+    std::cout.rdbuf (previous);
+    std::remove ((name + ".json").c_str());
+  }
+  return *found;
+}
+
+// Runs a command through a file session, as a script would, with the
+// display output thrown away
+static void runCommand (UMLCLI& interface, const std::string& command)
+{
+  Cli cli = interface.cli_menu();
+  std::ostringstream discard;
+  std::streambuf* previous = std::cout.rdbuf (discard.rdbuf());
+  std::istringstream in (command + "\n");
+  CliFileSession session (cli, in, discard);
+  session.Start();
+  std::cout.rdbuf (previous);
+}
+
+static void BM_ListClasses (benchmark::State& state)
+{
+  UMLGeneratorOptions options;
+  options.classes = state.range (0);
+  UMLCLI& interface = cliModel (options);
+  for (auto _ : state)
+    runCommand (interface, "class list");
+  state.SetComplexityN (state.range (0));
+}
+MODEL_SIZES (BM_ListClasses);
+
+// A single class whose methods are mostly overloads of each other, sized
+// by its method count
+static void BM_ViewClass (benchmark::State& state)
+{
+  UMLGeneratorOptions options;
+  options.classes = 1;
+  options.minMethods = options.maxMethods = state.range (0);
+  options.overloadDensity = 0.9;
+  UMLCLI& interface = cliModel (options);
+  std::string command = "class view " + interface.return_model().getClasses().front().getName();
+  for (auto _ : state)
+    runCommand (interface, command);
+  state.SetComplexityN (state.range (0));
+}
+BENCHMARK (BM_ViewClass)->Arg (10)->Arg (100)->Arg (1000)->Complexity()->Unit (benchmark::kMicrosecond);
+
+/************************************************************/
+// Serving pages
+
+// Port of the server the page benchmarks start, apart from the usual one
+static const int BENCHMARK_PORT = 60556;
+
+// Client of a server running in this process. The server is started on
+// first use and left running until the benchmarks exit.
+static httplib::Client& pageServer ()
+{
+  static httplib::Client client ("localhost", BENCHMARK_PORT);
+  static bool started = false;
+  if (!started)
+  {
+    std::thread ([] {
+      static UMLServer server;
+      server.start (BENCHMARK_PORT);
+    }).detach();
+    while (!client.Get ("/help"))
+      std::this_thread::sleep_for (std::chrono::milliseconds (10));
+    started = true;
+  }
+  return client;
+}
+
+// Reports the median and 99th percentile of the latencies as counters,
+// since the mean hides the slow requests
+static void reportPercentiles (benchmark::State& state, std::vector<double>& latencies)
+{
+  std::sort (latencies.begin(), latencies.end());
+  state.counters["p50_us"] = UMLLoadGenerator::percentile (latencies, 0.5) * 1e6;
+  state.counters["p99_us"] = UMLLoadGenerator::percentile (latencies, 0.99) * 1e6;
+}
+
+// Fetches a page over HTTP from end to end
+static void BM_ServePage (benchmark::State& state, const char* path)
+{
+  httplib::Client& client = pageServer();
+  std::vector<double> latencies;
+  for (auto _ : state)
+  {
+    auto start = std::chrono::steady_clock::now();
+    auto res = client.Get (path);
+    latencies.push_back (std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count());
+    if (!res || res->status != 200)
+    {
+      state.SkipWithError ("Request failed");
+      break;
+    }
+  }
+  reportPercentiles (state, latencies);
+}
+BENCHMARK_CAPTURE (BM_ServePage, index, "/")->UseRealTime()->Unit (benchmark::kMicrosecond);
+BENCHMARK_CAPTURE (BM_ServePage, help, "/help")->UseRealTime()->Unit (benchmark::kMicrosecond);
+
+// Renders the help page from the template cache, or parses it for every
+// render in a new environment the way requests did before the cache
+static void BM_RenderHelp (benchmark::State& state, bool cached)
+{
+  const std::string path = "helpGUI.html";
+  UMLTemplateCache cache;
+  std::string source = UMLEmbeddedFiles::find (path)->contents();
+  json data = model (10).getJson();
+  std::vector<double> latencies;
+  for (auto _ : state)
+  {
+    auto start = std::chrono::steady_clock::now();
+    if (cached)
+      benchmark::DoNotOptimize (cache.render (path, data));
+    else
+    {
+      inja::Environment env;
+      benchmark::DoNotOptimize (env.render (env.parse (source), data));
+    }
+    latencies.push_back (std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count());
+  }
+  reportPercentiles (state, latencies);
+}
+BENCHMARK_CAPTURE (BM_RenderHelp, parsed_per_request, false)->Unit (benchmark::kMicrosecond);
+BENCHMARK_CAPTURE (BM_RenderHelp, cached, true)->Unit (benchmark::kMicrosecond);
+
+// Serializes the model with attribute ids, as the index page and full
+// deltas do
+static void BM_IndexedJson (benchmark::State& state)
+{
+  UMLData& data = model (state.range (0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize (UMLServer::indexedJson (data));
+  state.SetComplexityN (state.range (0));
+}
+BENCHMARK (BM_IndexedJson)->Arg (1000)->Arg (10000)->Complexity()->Unit (benchmark::kMillisecond);
+
+// Renders the index page from scratch the way the index route does when
+// its page isn't cached: indexedJson, then the cached template
+static void BM_RenderIndex (benchmark::State& state)
+{
+  UMLTemplateCache cache;
+  UMLData& data = model (state.range (0));
+  std::vector<double> latencies;
+  for (auto _ : state)
+  {
+    auto start = std::chrono::steady_clock::now();
+    json j = UMLServer::indexedJson (data);
+    j["errors"] = json::array();
+    j["success"] = json::array();
+    j["files"] = json::array();
+    j["view"] = {{"object", "all"}, {"name", ""}, {"name2", ""}};
+    j["version"] = 1;
+    j["document"] = "default";
+    benchmark::DoNotOptimize (cache.render ("templates/index.html", j));
+    latencies.push_back (std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count());
+  }
+  reportPercentiles (state, latencies);
+  state.SetComplexityN (state.range (0));
+}
+BENCHMARK (BM_RenderIndex)->Arg (1000)->Arg (10000)->Complexity()->Unit (benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+/*
+  Filename   : Generate.cpp
+  Description: Writes a synthetic diagram from a seed, for repeatable
+  performance work on large models. Run with no arguments for usage.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "umllib/include/UMLGenerator.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+//--------------------------------------------------------------------
+
+static const char* USAGE =
+  "Usage: generate [options] <file_name>\n"
+  "  --seed N              Seed, the same options always give the same diagram (1)\n"
+  "  --classes N           Number of classes (100)\n"
+  "  --fields MIN[-MAX]    Fields per class (0-6)\n"
+  "  --methods MIN[-MAX]   Methods per class (0-6)\n"
+  "  --params MIN[-MAX]    Parameters per method (0-3)\n"
+  "  --overloads P         Chance a method overloads an earlier one (0.1)\n"
+  "  --types N             Number of type names used (12)\n"
+  "  --shape SHAPE         tree, dense or scale-free (tree)\n"
+  "  --degree N            Relationships per class for dense and scale-free (3)\n";
+
+// Reads "3" or "2-5" into an inclusive range
+static void parseRange(const std::string& text, size_t& low, size_t& high)
+{
+  size_t dash = text.find('-');
+  low = std::stoul(text.substr(0, dash));
+  high = dash == std::string::npos ? low : std::stoul(text.substr(dash + 1));
+}
+
+int main(int argc, char** argv)
+{
+  UMLGeneratorOptions options;
+  std::string path;
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string argument = argv[i];
+      if (argument.rfind("--", 0) != 0)
+      {
+        path = argument;
+        continue;
+      }
+      if (i + 1 == argc)
+        throw std::runtime_error("Missing value for " + argument);
+      std::string value = argv[++i];
+
+      if (argument == "--seed")
+        options.seed = std::stoull(value);
+      else if (argument == "--classes")
+        options.classes = std::stoul(value);
+      else if (argument == "--fields")
+        parseRange(value, options.minFields, options.maxFields);
+      else if (argument == "--methods")
+        parseRange(value, options.minMethods, options.maxMethods);
+      else if (argument == "--params")
+        parseRange(value, options.minParams, options.maxParams);
+      else if (argument == "--overloads")
+        options.overloadDensity = std::stod(value);
+      else if (argument == "--types")
+        options.typeCount = std::stoul(value);
+      else if (argument == "--shape")
+        options.shape = UMLGenerator::shapeFromString(value);
+      else if (argument == "--degree")
+        options.degree = std::stoul(value);
+      else
+        throw std::runtime_error("Unknown option " + argument);
+    }
+    if (path.empty())
+    {
+      std::cerr << USAGE;
+      return 1;
+    }
+
+    UMLGenerator generator(options);
+    auto start = std::chrono::steady_clock::now();
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+      throw std::runtime_error("Could not open " + path);
+    generator.write(file);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Wrote " << options.classes << " classes to " << path
+      << " in " << elapsed.count() << "s\n";
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << error.what() << "\n" << USAGE;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,96 @@
+/*
+  Filename   : LoadTest.cpp
+  Description: Drives a mixed workload against a UMLServer running on this
+  machine and prints throughput and latency for each route. Run with
+  --help for usage.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "umllib/include/UMLLoadGenerator.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+//--------------------------------------------------------------------
+
+static const char* USAGE =
+  "Usage: loadtest [options]\n"
+  "  --port N          Port the server listens on (60555)\n"
+  "  --workers N       Connections sending requests at once (4)\n"
+  "  --requests N      Requests across all workers (2000)\n"
+  "  --rate R          Requests per second for an open loop, 0 for closed (0)\n"
+  "  --seed N          Seed, the same seed sends the same requests (1)\n"
+  "  --document NAME   Document to edit (loadtest)\n"
+  "  --json            Print the report as json\n";
+
+// Prints one row of the report table
+static void printRow(const std::string& route, const json& summary)
+{
+  std::printf("%-24s %8zu %7zu %9.1f %9.2f %9.2f %9.2f\n", route.c_str(),
+    summary["count"].get<size_t>(), summary["errors"].get<size_t>(),
+    summary["throughput"].get<double>(), summary["p50"].get<double>(),
+    summary["p99"].get<double>(), summary["p999"].get<double>());
+}
+
+int main(int argc, char** argv)
+{
+  UMLLoadOptions options;
+  bool printJson = false;
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string argument = argv[i];
+      if (argument == "--json")
+      {
+        printJson = true;
+        continue;
+      }
+      if (argument == "--help")
+      {
+        std::cout << USAGE;
+        return 0;
+      }
+      if (i + 1 == argc)
+        throw std::runtime_error("Missing value for " + argument);
+      std::string value = argv[++i];
+
+      if (argument == "--port")
+        options.port = std::stoi(value);
+      else if (argument == "--workers")
+        options.workers = std::stoul(value);
+      else if (argument == "--requests")
+        options.requests = std::stoul(value);
+      else if (argument == "--rate")
+        options.rate = std::stod(value);
+      else if (argument == "--seed")
+        options.seed = std::stoull(value);
+      else if (argument == "--document")
+        options.document = value;
+      else
+        throw std::runtime_error("Unknown option " + argument);
+    }
+
+    json report = UMLLoadGenerator(options).run();
+    if (printJson)
+    {
+      std::cout << report.dump(2) << "\n";
+      return 0;
+    }
+
+    std::printf("%s loop, %zu workers, seed %llu, %.2fs\n", report["mode"].get<std::string>().c_str(),
+      options.workers, options.seed, report["seconds"].get<double>());
+    std::printf("%-24s %8s %7s %9s %9s %9s %9s\n", "route", "count", "errors", "req/s", "p50 ms", "p99 ms", "p999 ms");
+    for (const auto& route : report["routes"].items())
+      printRow(route.key(), route.value());
+    if (report.contains("total"))
+      printRow("total", report["total"]);
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << error.what() << "\n" << USAGE;
+    return 1;
+  }
+  return 0;
+}
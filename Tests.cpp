@@ -22,18 +22,46 @@
 #include "cli/cli.h"
 #include "cli/clifilesession.h"
 
+#include "umllib/include/UMLBoxRenderer.hpp"
+#include "umllib/include/UMLChangeFeed.hpp"
 #include "umllib/include/UMLCLI.hpp"
 #include "umllib/include/UMLClass.hpp"
+#include "umllib/include/UMLCompression.hpp"
 #include "umllib/include/UMLData.hpp"
 #include "umllib/include/UMLDataHistory.hpp"
+#include "umllib/include/UMLDocumentStore.hpp"
+#include "umllib/include/UMLEmbeddedFiles.hpp"
+#include "umllib/include/UMLField.hpp"
+#include "umllib/include/UMLFile.hpp"
+#include "umllib/include/UMLFootprint.hpp"
+#include "umllib/include/UMLGenerator.hpp"
+#include "umllib/include/UMLListFilter.hpp"
+#include "umllib/include/UMLLoadGenerator.hpp"
 #include "umllib/include/UMLMethod.hpp"
+#include "umllib/include/UMLMetrics.hpp"
+#include "umllib/include/UMLNameCompleter.hpp"
+#include "umllib/include/UMLNameIndex.hpp"
+#include "umllib/include/UMLPageCache.hpp"
 #include "umllib/include/UMLParameter.hpp"
 #include "umllib/include/UMLRelationship.hpp"
+#include "umllib/include/UMLSaveCatalog.hpp"
+#include "umllib/include/UMLSaveWriter.hpp"
+#include "umllib/include/UMLServer.hpp"
+#include "umllib/include/UMLSharedModel.hpp"
+#include "umllib/include/UMLStaticAssets.hpp"
+#include "umllib/include/UMLTrace.hpp"
 #include "umllib/include/CLITest.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 
 using namespace std;
 using namespace cli;
@@ -65,6 +93,10 @@ UMLData
 UMLDataHistory
 UMLCLI
 UMLServer (## WIP ##)
+UMLTrace
+UMLGenerator
+UMLSaveWriter
+UMLLoadGenerator
 */
 
 // ****************************************************
@@ -318,6 +350,90 @@ TEST (UMLClassTest, CheckAttributesTest)
     << "Methods have different types, but params are same so it shouldn't work";
 }
 
+// Test that overload numbers follow adds, renames and deletes
+TEST (UMLClassTest, OverloadTableTest)
+{
+  UMLClass class1 ("test");
+  auto makeMethod = [] (string name, string paramType) {
+    return std::make_shared<UMLMethod> (name, "void", std::list<UMLParameter>{UMLParameter ("p", paramType)});
+  };
+  shared_ptr<UMLMethod> first = makeMethod ("draw", "int");
+  shared_ptr<UMLMethod> other = makeMethod ("paint", "int");
+  shared_ptr<UMLMethod> second = makeMethod ("draw", "bool");
+  shared_ptr<UMLField> field = std::make_shared<UMLField> ("count", "int");
+  class1.addAttribute (first);
+  class1.addAttribute (other);
+  class1.addAttribute (second);
+  class1.addAttribute (field);
+
+  ASSERT_EQ (1, class1.getOverloadNumber (*first));
+  ASSERT_EQ (2, class1.getOverloadNumber (*second));
+  ASSERT_EQ (1, class1.getOverloadNumber (*other));
+  ASSERT_EQ (0, class1.getOverloadNumber (*field));
+  ASSERT_EQ (second, class1.getOverload ("draw", 2));
+  ASSERT_EQ (nullptr, class1.getOverload ("draw", 3));
+  ASSERT_EQ (nullptr, class1.getOverload ("count", 1));
+
+  // A renamed method keeps its place in the class, so lands between the two
+  class1.changeAttributeName (other, "draw");
+  ASSERT_EQ (1, class1.getOverloadNumber (*first));
+  ASSERT_EQ (2, class1.getOverloadNumber (*other));
+  ASSERT_EQ (3, class1.getOverloadNumber (*second));
+  ASSERT_EQ (nullptr, class1.getOverload ("paint", 1));
+
+  // Later overloads move up when one is deleted
+  class1.deleteAttribute (first);
+  ASSERT_EQ (0, class1.getOverloadNumber (*first));
+  ASSERT_EQ (1, class1.getOverloadNumber (*other));
+  ASSERT_EQ (2, class1.getOverloadNumber (*second));
+  ASSERT_EQ (other, class1.getOverload ("draw", 1));
+}
+
+// Attribute ids should not move when other attributes are removed, and
+// should survive a clone of the model and a trip through its history
+TEST (UMLClassTest, AttributeIdTest)
+{
+  UMLData data;
+  data.addClass ("a");
+  data.addClassAttribute ("a", std::make_shared<UMLField> ("x", "int"));
+  data.addClassAttribute ("a", std::make_shared<UMLField> ("y", "int"));
+  data.addClassAttribute ("a", std::make_shared<UMLField> ("z", "int"));
+  ASSERT_EQ ("z", data.getClass ("a").getAttributeById (3)->getAttributeName());
+
+  data.removeClassAttribute ("a", data.getClass ("a").getAttributeById (1));
+  ASSERT_EQ ("y", data.getClass ("a").getAttributeById (2)->getAttributeName());
+  ASSERT_EQ ("z", data.getClass ("a").getAttributeById (3)->getAttributeName());
+  ASSERT_THROW (data.getClass ("a").getAttributeById (1), std::runtime_error);
+
+  // Removed ids are not handed out again
+  data.addClassAttribute ("a", std::make_shared<UMLField> ("w", "int"));
+  ASSERT_EQ ("w", data.getClass ("a").getAttributeById (4)->getAttributeName());
+
+  UMLData copy = data.clone();
+  ASSERT_EQ ("z", copy.getClass ("a").getAttributeById (3)->getAttributeName());
+  // The copy shares nothing, so editing it leaves the original alone
+  copy.changeAttributeName ("a", copy.getClass ("a").getAttributeById (3), "v");
+  ASSERT_EQ ("z", data.getClass ("a").getAttributeById (3)->getAttributeName());
+  ASSERT_EQ (data.getJson().dump().size(), copy.getJson().dump().size());
+
+  // History snapshots keep ids through undo, redo and a round trip through
+  // json, while save files leave them out
+  UMLDataHistory history (data);
+  data.removeClassAttribute ("a", data.getClass ("a").getAttributeById (2));
+  history.save (data);
+  UMLData undone = history.undo();
+  ASSERT_EQ ("y", undone.getClass ("a").getAttributeById (2)->getAttributeName());
+  ASSERT_EQ ("z", undone.getClass ("a").getAttributeById (3)->getAttributeName());
+  ASSERT_EQ ("w", undone.getClass ("a").getAttributeById (4)->getAttributeName());
+  UMLData redone = history.redo();
+  ASSERT_THROW (redone.getClass ("a").getAttributeById (2), std::runtime_error);
+  ASSERT_EQ ("z", redone.getClass ("a").getAttributeById (3)->getAttributeName());
+  UMLDataHistory restored (data);
+  restored.setJson (history.getJson());
+  ASSERT_EQ ("w", restored.load_current().getClass ("a").getAttributeById (4)->getAttributeName());
+  ASSERT_FALSE (data.getJson()["classes"][0]["fields"][0].contains ("id"));
+}
+
 // ****************************************************
 
 /*
@@ -820,6 +936,88 @@ TEST (UMLFileTest, SaveLoadTest)
   remove("test.json");
 }
 
+// The save catalog should list saves with their header info and notice removed files
+TEST (UMLFileTest, SaveCatalogTest)
+{
+  std::filesystem::remove_all ("catalogtest");
+  std::filesystem::create_directory ("catalogtest");
+  UMLSaveCatalog catalog ("catalogtest");
+  ASSERT_EQ (0, catalog.listSaves().size());
+
+  UMLData data;
+  data.addClass ("fish");
+  data.addClass ("fish2");
+  UMLFile file ("catalogtest/diagram.json");
+  file.save (data);
+  // UMLFile only tells the working catalog about its writes
+  catalog.touch ("catalogtest/diagram.json");
+  // Other files in the directory are not saves
+  std::ofstream other ("catalogtest/notes.txt");
+  other << "not a save";
+  other.close();
+  catalog.touch ("catalogtest/notes.txt");
+
+  json info = catalog.listSaveInfo();
+  ASSERT_EQ (1, info.size());
+  ASSERT_EQ ("diagram", info[0]["name"]);
+  ASSERT_EQ (2, info[0]["classes"]);
+  ASSERT_GT (info[0]["size"].get<int>(), 0);
+  ASSERT_EQ (json::array ({"diagram"}), catalog.listSaves());
+
+  // A removed file should drop out of the listing
+  std::filesystem::remove ("catalogtest/diagram.json");
+  catalog.invalidate();
+  ASSERT_EQ (0, catalog.listSaves().size());
+
+  std::filesystem::remove_all ("catalogtest");
+}
+
+// Saves added, or overwritten in place, straight after a listing should be
+// picked up without invalidating the catalog
+TEST (UMLFileTest, SaveCatalogChangeTest)
+{
+  std::filesystem::remove_all ("catalogchange");
+  std::filesystem::create_directory ("catalogchange");
+  UMLSaveCatalog catalog ("catalogchange");
+  UMLData data;
+  data.addClass ("fish");
+  UMLFile ("catalogchange/first.json").save (data);
+  ASSERT_EQ (json::array ({"first"}), catalog.listSaves());
+  unsigned long generation = catalog.generation();
+  ASSERT_EQ (generation, catalog.generation());
+
+  // Written within the same tick as the scan above. UMLFile only tells
+  // the working catalog about its writes.
+  UMLFile ("catalogchange/second.json").save (data);
+  catalog.touch ("catalogchange/second.json");
+  ASSERT_EQ (json::array ({"first", "second"}), catalog.listSaves());
+  ASSERT_NE (generation, catalog.generation());
+
+  // Overwriting a save in place updates its entry once touched
+  ASSERT_EQ (1, catalog.listSaveInfo()[0]["classes"]);
+  data.addClass ("fish2");
+  data.addClass ("fish3");
+  UMLFile ("catalogchange/first.json").save (data);
+  catalog.touch ("catalogchange/first.json");
+  json info = catalog.listSaveInfo();
+  ASSERT_EQ ("first", info[0]["name"]);
+  ASSERT_EQ (3, info[0]["classes"]);
+
+  // Names and generation are handed out together
+  UMLSaveCatalog::Listing listing = catalog.listing();
+  ASSERT_EQ (catalog.listSaves(), *listing.names);
+  ASSERT_EQ (catalog.generation(), listing.generation);
+
+  // Changes made behind the catalog's back show up once invalidated
+  std::filesystem::remove ("catalogchange/second.json");
+  catalog.invalidate();
+  ASSERT_EQ (json::array ({"first"}), catalog.listSaves());
+  ASSERT_NE (listing.generation, catalog.generation());
+  ASSERT_EQ (json::array ({"first", "second"}), *listing.names);
+
+  std::filesystem::remove_all ("catalogchange");
+}
+
 // Adding a parameter to a method that would cause overloading rules to fail should not work
 TEST (CLITest, ParameterOverloadAdd)
 {
@@ -957,6 +1155,145 @@ TEST (UMLDataClassTest, RenameClassIntoClassThatAlreadyExists)
              "Class name already exists");
 }
 
+// The name index should follow every change to names and types
+TEST (UMLDataClassTest, NameIndexTest)
+{
+  UMLData data;
+  data.addClass ("Shape");
+  data.addClass ("Shadow");
+  data.addClass ("Circle");
+  ASSERT_EQ ((vector<string> {"Shadow", "Shape"}), data.getNameIndex().complete (UMLNameKind::className, "Sha"));
+
+  method_ptr area = std::make_shared<UMLMethod> ("area", "double", list<UMLParameter> {UMLParameter ("scale", "Ratio")});
+  data.addClassAttribute ("Shape", std::make_shared<UMLField> ("sides", "int"));
+  data.addClassAttribute ("Circle", std::make_shared<UMLField> ("sides", "int"));
+  data.addClassAttribute ("Shape", area);
+  ASSERT_EQ ((vector<string> {"Ratio", "double", "int"}), data.getNameIndex().complete (UMLNameKind::type, ""));
+  ASSERT_EQ ((vector<string> {"area"}), data.getNameIndex().complete (UMLNameKind::method, "a"));
+
+  // Shared names stay until their last use goes
+  data.removeClassAttribute ("Circle", data.getClass ("Circle").getAttribute ("sides"));
+  ASSERT_TRUE (data.getNameIndex().contains (UMLNameKind::field, "sides"));
+  data.deleteClass ("Shape");
+  ASSERT_FALSE (data.getNameIndex().contains (UMLNameKind::field, "sides"));
+  ASSERT_FALSE (data.getNameIndex().contains (UMLNameKind::method, "area"));
+  ASSERT_EQ (0, data.getNameIndex().size (UMLNameKind::type));
+
+  // Renames and type changes swap the old name for the new one
+  data.changeClassName ("Circle", "Ring");
+  ASSERT_FALSE (data.doesClassExist ("Circle"));
+  ASSERT_TRUE (data.doesClassExist ("Ring"));
+  method_ptr radius = std::make_shared<UMLMethod> ("radius", "int", list<UMLParameter> {});
+  data.addClassAttribute ("Ring", radius);
+  data.addParameter ("Ring", radius, "unit", "Length");
+  data.changeParameterType ("Ring", radius, "unit", "Distance");
+  data.changeAttributeType (radius, "float");
+  data.changeAttributeName ("Ring", radius, "size");
+  ASSERT_EQ ((vector<string> {"Distance", "float"}), data.getNameIndex().complete (UMLNameKind::type, ""));
+  ASSERT_EQ ((vector<string> {"size"}), data.getNameIndex().complete (UMLNameKind::method, ""));
+  data.deleteParameter ("Ring", radius, "unit");
+  ASSERT_FALSE (data.getNameIndex().contains (UMLNameKind::type, "Distance"));
+
+  // Copies carry the index with them
+  UMLData copy = data.clone();
+  ASSERT_TRUE (copy.doesClassExist ("Ring"));
+  ASSERT_EQ ((vector<string> {"size"}), copy.getNameIndex().complete (UMLNameKind::method, "s"));
+}
+
+// The footprint is kept as the model changes, so it should match one
+// built from scratch and go back to nothing once everything is deleted
+TEST (UMLDataClassTest, FootprintTest)
+{
+  UMLData data;
+  UMLFootprint empty = data.getFootprint();
+  ASSERT_EQ (0, empty.getTotalBytes());
+
+  // Names too long to be kept inside their strings are counted on the heap
+  data.addClass ("ShapeWithAVeryLongName");
+  data.addClass ("Circle");
+  data.addClassAttribute ("Circle", std::make_shared<UMLField> ("radiusInMillimetres", "int"));
+  method_ptr area = std::make_shared<UMLMethod> ("area", "double", list<UMLParameter> {UMLParameter ("scale", "Ratio")});
+  data.addClassAttribute ("ShapeWithAVeryLongName", area);
+  data.addParameter ("ShapeWithAVeryLongName", area, "precisionInDecimalPlaces", "int");
+  data.addRelationship ("Circle", "ShapeWithAVeryLongName", generalization);
+  UMLFootprint footprint = data.getFootprint();
+  ASSERT_EQ (2, footprint.getClassCount());
+  ASSERT_EQ (1, footprint.getFieldCount());
+  ASSERT_EQ (1, footprint.getMethodCount());
+  ASSERT_EQ (2, footprint.getParameterCount());
+  ASSERT_EQ (1, footprint.getRelationshipCount());
+  ASSERT_EQ (UMLFootprint::heapBytes ("ShapeWithAVeryLongName") + UMLFootprint::heapBytes ("radiusInMillimetres")
+    + UMLFootprint::heapBytes ("precisionInDecimalPlaces"), footprint.getStringBytes());
+  ASSERT_GT (footprint.getIndexBytes(), 0);
+  ASSERT_GT (footprint.getOverheadBytes(), 0);
+
+  // Renames, type changes and deletes keep it in step with the model
+  data.changeClassName ("ShapeWithAVeryLongName", "Shape");
+  data.changeAttributeName ("Shape", area, "surfaceAreaInSquareUnits");
+  data.changeParameterName (area, "scale", "scaleFactorForTheShape");
+  data.changeParameterType ("Shape", area, "scaleFactorForTheShape", "RatioOfTwoLengthsInUnits");
+  data.changeAttributeType (area, "LongDoublePrecisionNumber");
+  data.deleteParameter ("Shape", area, "precisionInDecimalPlaces");
+  json rebuilt = data.getJson();
+  UMLData copy;
+  UMLFile::addClasses (copy, rebuilt);
+  UMLFile::addRelationships (copy, rebuilt);
+  json changed = data.getFootprint().toJson();
+  json expected = copy.getFootprint().toJson();
+  changed["bytes"].erase ("relationships");
+  changed["bytes"].erase ("total");
+  expected["bytes"].erase ("relationships");
+  expected["bytes"].erase ("total");
+  ASSERT_EQ (expected, changed);
+
+  data.deleteClass ("Shape");
+  data.deleteClass ("Circle");
+  footprint = data.getFootprint();
+  ASSERT_EQ (0, footprint.getClassCount());
+  ASSERT_EQ (0, footprint.getStringBytes());
+  ASSERT_EQ (0, footprint.getIndexBytes());
+  ASSERT_EQ (footprint.getRelationshipBytes() + UMLFootprint::ALLOCATION_OVERHEAD, footprint.getTotalBytes());
+}
+
+// Each snapshot is measured once, and the total follows them between the
+// undo and redo stacks
+TEST (UMLDataClassTest, HistoryBytesTest)
+{
+  UMLData data;
+  UMLDataHistory history (data);
+  size_t start = history.snapshot_bytes();
+  ASSERT_EQ (UMLFootprint::jsonBytes (data.getJson()), start);
+
+  data.addClass ("Shape");
+  history.save (data);
+  data.addClass ("Circle");
+  history.save (data);
+  size_t saved = history.snapshot_bytes();
+  ASSERT_GT (saved, start);
+
+  history.undo();
+  ASSERT_EQ (saved, history.snapshot_bytes());
+  history.redo();
+  ASSERT_EQ (saved, history.snapshot_bytes());
+
+  // Taking another snapshot drops what could have been redone
+  history.undo();
+  data = history.undo();
+  data.addClass ("Square");
+  history.save (data);
+  ASSERT_TRUE (history.is_redo_empty());
+  json j = history.getJson();
+  size_t expected = UMLFootprint::jsonBytes (j["current"]);
+  for (const json& snapshot : j["undos"])
+    expected += UMLFootprint::jsonBytes (snapshot);
+  for (const json& snapshot : j["redos"])
+    expected += UMLFootprint::jsonBytes (snapshot);
+  ASSERT_EQ (expected, history.snapshot_bytes());
+
+  UMLDataHistory restored (data);
+  restored.setJson (j);
+  ASSERT_EQ (expected, restored.snapshot_bytes());
+}
 // ****************************************************
 
 // Tests involving attributes (method/field)
@@ -3309,4 +3646,843 @@ TEST (CLITest, ChangeRelationshipTypeErrors)
   test.user_input(cli, oss, "relationships change test test realization");
   data = interface.return_model();
   ASSERT_EQ (data.getRelationship ("test", "test").getType(), aggregation);
-}
\ No newline at end of file
+}
+
+// Scripts should run without prompts and report each command as json
+TEST (CLITest, ScriptMode)
+{
+  UMLCLI interface;
+  stringstream script ("class add bob\n\n# comment\nclass add bob\nfield add bob int count\nbogus\n");
+  stringstream output;
+  ASSERT_EQ (2, interface.run_script (script, output));
+
+  vector<json> results;
+  string line;
+  while (getline (output, line))
+    results.push_back (json::parse (line));
+  ASSERT_EQ (5, results.size());
+  ASSERT_EQ (1, results[0]["line"]);
+  ASSERT_TRUE (results[0]["ok"].get<bool>());
+  ASSERT_EQ (4, results[1]["line"]);
+  ASSERT_FALSE (results[1]["ok"].get<bool>());
+  ASSERT_TRUE (results[2]["ok"].get<bool>());
+  ASSERT_FALSE (results[3]["ok"].get<bool>());
+  ASSERT_EQ (4, results[4]["summary"]["commands"]);
+  ASSERT_EQ (2, results[4]["summary"]["failed"]);
+  ASSERT_TRUE (interface.return_model().doesFieldExist ("bob", "count"));
+
+  // Undo takes back every edit since the script started
+  UMLCLI batched;
+  stringstream edits ("class add a\nclass add b\nundo\n");
+  ASSERT_EQ (0, batched.run_script (edits, output));
+  ASSERT_FALSE (batched.return_model().doesClassExist ("a"));
+  ASSERT_FALSE (batched.return_model().doesClassExist ("b"));
+}
+
+// Classes render as boxes, with overloads numbered among methods sharing a name
+TEST (CLITest, BoxRenderer)
+{
+  UMLClass box ("Box");
+  box.addAttribute (std::make_shared<UMLField> ("width", "int"));
+  box.addAttribute (std::make_shared<UMLMethod> ("area", "int", list<UMLParameter> {}));
+  box.addAttribute (std::make_shared<UMLMethod> ("area", "int", list<UMLParameter> {UMLParameter ("s", "double")}));
+  box.addAttribute (std::make_shared<UMLField> ("height", "int"));
+  box.addAttribute (std::make_shared<UMLMethod> ("draw", "void", list<UMLParameter> {UMLParameter ("g", "Graphics"), UMLParameter ("c", "Color")}));
+  ASSERT_EQ ((vector<int> {0, 1, 2, 0, 1}), UMLBoxRenderer::overloadNumbers (box));
+
+  UMLBoxRenderer renderer;
+  renderer.renderClass (box);
+  ASSERT_EQ (
+    "+------------------------------------------+\n"
+    "| Box                                      |\n"
+    "+------------------------------------------+\n"
+    "| width : int                              |\n"
+    "| height : int                             |\n"
+    "+------------------------------------------+\n"
+    "| area() : int [1]                         |\n"
+    "| area(s : double) : int [2]               |\n"
+    "| draw(g : Graphics, c : Color) : void [1] |\n"
+    "+------------------------------------------+\n"
+    "\n", renderer.str());
+
+  // Flushing writes everything once and leaves the buffer empty
+  stringstream out;
+  renderer.flush (out);
+  ASSERT_TRUE (renderer.str().empty());
+
+  // Empty sections get no closing edge
+  renderer.renderRelationship (UMLClass ("A"), UMLClass ("LongerName"), "composition");
+  ASSERT_EQ (
+    "TYPE: composition\n\n"
+    "SOURCE:\n+---+\n| A |\n+---+\n\n"
+    "DESTINATION:\n+------------+\n| LongerName |\n+------------+\n\n", renderer.str());
+}
+
+// Arguments complete from their sources, repeating the line before them
+TEST (CLITest, NameCompleter)
+{
+  UMLNameCompleter completer;
+  UMLNameCompleter::Source classes = [] (const vector<string>& previous, const string& prefix) {
+    vector<string> names;
+    for (string name : {"Shadow", "Shape", "Circle"})
+      if (name.compare (0, prefix.size(), prefix) == 0)
+        names.push_back (name);
+    return names;
+  };
+  completer.add ("rename", {classes, nullptr});
+  completer.add ("relate", {classes, classes});
+
+  ASSERT_EQ ((vector<string> {"rename Shadow", "rename Shape"}), completer.GetCompletionRecursive ("rename Sha"));
+  ASSERT_EQ ((vector<string> {"relate Shape Circle"}), completer.GetCompletionRecursive ("relate Shape  C"));
+  ASSERT_EQ (3, completer.GetCompletionRecursive ("relate Shape ").size());
+  // Command names, new names and unknown commands are left alone
+  ASSERT_TRUE (completer.GetCompletionRecursive ("rena").empty());
+  ASSERT_TRUE (completer.GetCompletionRecursive ("rename Shape S").empty());
+  ASSERT_TRUE (completer.GetCompletionRecursive ("delete S").empty());
+}
+
+// Listing options filter, page and count classes and relationships
+TEST (CLITest, ListFilter)
+{
+  UMLData data;
+  data.addClass ("Shape");
+  data.addClass ("Shadow");
+  data.addClass ("Circle");
+  data.addClassAttribute ("Circle", std::make_shared<UMLField> ("radius", "double"));
+  data.addRelationship ("Shape", "Circle", 0);
+  data.addRelationship ("Shadow", "Shape", 2);
+  data.addRelationship ("Circle", "Shadow", 0);
+
+  ASSERT_TRUE (UMLListFilter::globMatch ("Sh*w", "Shadow"));
+  ASSERT_TRUE (UMLListFilter::globMatch ("*a?e", "Shape"));
+  ASSERT_FALSE (UMLListFilter::globMatch ("Sh*w", "Shape"));
+
+  // Prefixes are counted from the name index, globs by checking each class
+  UMLListFilter prefix ({"--name", "Sha", "--count"}, UMLListSubject::classes);
+  ASSERT_TRUE (prefix.counting());
+  ASSERT_EQ (2, prefix.countClasses (data));
+  ASSERT_EQ (2, UMLListFilter ({"--name", "*e"}, UMLListSubject::classes).countClasses (data));
+  UMLListFilter member ({"--member-type", "double"}, UMLListSubject::classes);
+  ASSERT_TRUE (member.matches (data.getClass ("Circle")));
+  ASSERT_FALSE (member.matches (data.getClass ("Shape")));
+
+  // Relationship types are counted as they change
+  UMLListFilter aggregations ({"--type", "Aggregation"}, UMLListSubject::relationships);
+  ASSERT_EQ (2, aggregations.countRelationships (data));
+  data.changeRelationshipType ("Circle", "Shadow", 1);
+  data.deleteClass ("Shape");
+  ASSERT_EQ (0, aggregations.countRelationships (data));
+  ASSERT_EQ (1, data.countRelationships (composition));
+  ASSERT_EQ (1, UMLListFilter ({"--name", "Sha"}, UMLListSubject::relationships).countRelationships (data));
+
+  // Pages count from 1, with a default size when none is given
+  UMLListFilter page ({"--page", "3"}, UMLListSubject::classes);
+  ASSERT_TRUE (page.paged());
+  ASSERT_EQ (2 * UMLListFilter::DEFAULT_PAGE_SIZE, page.pageStart());
+  ASSERT_EQ (3 * UMLListFilter::DEFAULT_PAGE_SIZE, page.pageEnd());
+  ASSERT_FALSE (UMLListFilter ({}, UMLListSubject::classes).paged());
+
+  ERR_CHECK (UMLListFilter ({"--type", "aggregation"}, UMLListSubject::classes), "Unknown option: --type");
+  ERR_CHECK (UMLListFilter ({"--page", "0"}, UMLListSubject::classes), "--page needs a positive number");
+  ERR_CHECK (UMLListFilter ({"--name"}, UMLListSubject::classes), "--name needs a value");
+  ERR_CHECK (UMLListFilter ({"--type", "friendship"}, UMLListSubject::relationships), "Unknown relationship type: friendship");
+}
+
+// ****************************************************
+
+/*
+////////////////////////////////\\\\\\\\\\\\\\\\
+|**************************************************************|
+|                     Tests for UMLServer                      |
+|**************************************************************|
+\\\\\\\\\\\\\\\\////////////////////////////////
+*/
+
+// Cached pages should only be returned for the version they were rendered at
+TEST (UMLServerTest, PageCacheVersionTest)
+{
+  UMLPageCache pages;
+  ASSERT_EQ (nullptr, pages.find ("index", 0));
+
+  auto page = pages.store ("index", 1, "<html>1</html>");
+  ASSERT_EQ ("<html>1</html>", pages.find ("index", 1)->body);
+  ASSERT_EQ (nullptr, pages.find ("index", 2));
+  ASSERT_EQ (nullptr, pages.find ("data", 1));
+
+  // A newer render replaces the old one and gets a different tag
+  auto newPage = pages.store ("index", 2, "<html>2</html>");
+  ASSERT_NE (page->etag, newPage->etag);
+  ASSERT_EQ (nullptr, pages.find ("index", 1));
+
+  // Pages listing the saves go stale when the listing changes, and the new
+  // listing's page takes the old one's place
+  pages.store ("index", 2, "<html>saves 1</html>", 1);
+  ASSERT_EQ (nullptr, pages.find ("index", 2, 2));
+  pages.store ("index", 2, "<html>saves 2</html>", 2);
+  ASSERT_EQ ("<html>saves 2</html>", pages.find ("index", 2, 2)->body);
+  ASSERT_EQ (nullptr, pages.find ("index", 2, 1));
+}
+
+// If-None-Match should match strong tags, tag lists, and wildcards
+TEST (UMLServerTest, PageCacheETagTest)
+{
+  std::string etag = UMLPageCache::makeETag (4, "body");
+  ASSERT_EQ ('"', etag.front());
+  ASSERT_EQ ('"', etag.back());
+  ASSERT_EQ (etag, UMLPageCache::makeETag (4, "body"));
+
+  ASSERT_TRUE (UMLPageCache::matches (etag, etag));
+  ASSERT_TRUE (UMLPageCache::matches ("\"other\", " + etag, etag));
+  ASSERT_TRUE (UMLPageCache::matches ("*", etag));
+  ASSERT_FALSE (UMLPageCache::matches ("", etag));
+  ASSERT_FALSE (UMLPageCache::matches (UMLPageCache::makeETag (5, "body"), etag));
+}
+
+// Readers should get every event after their version, or be told to reset
+TEST (UMLServerTest, ChangeFeedTest)
+{
+  UMLChangeFeed feed (2);
+  std::vector<UMLChangeFeed::Event> events;
+  ASSERT_TRUE (feed.waitSince (0, std::chrono::milliseconds (0), events));
+  ASSERT_TRUE (events.empty());
+
+  feed.publish (1, "one");
+  feed.publish (2, "two");
+  ASSERT_TRUE (feed.waitSince (0, std::chrono::milliseconds (0), events));
+  ASSERT_EQ (2, events.size());
+  ASSERT_EQ ("one", events[0].payload);
+  ASSERT_EQ (2, events[1].version);
+
+  events.clear();
+  ASSERT_TRUE (feed.waitSince (1, std::chrono::milliseconds (0), events));
+  ASSERT_EQ (1, events.size());
+  ASSERT_EQ ("two", events[0].payload);
+
+  // Version 1 falls out of the feed, so a reader at 0 has missed it
+  feed.publish (3, "three");
+  events.clear();
+  ASSERT_FALSE (feed.waitSince (0, std::chrono::milliseconds (0), events));
+  // A version the feed has never seen means the server restarted
+  ASSERT_FALSE (feed.waitSince (9, std::chrono::milliseconds (0), events));
+  ASSERT_EQ (3, feed.latest());
+}
+
+// Hammers the shared model with mixed reads and writes. Build with
+// -DUML_THREAD_SANITIZER=ON to have ThreadSanitizer check it for races.
+// Records operations per second by thread count in the test's XML output.
+TEST (UMLServerTest, SharedModelStressTest)
+{
+  const int operationsPerThread = 200;
+  for (int threads : {1, 2, 4, 8})
+  {
+    std::atomic<unsigned long> published {0};
+    UMLSharedModel model ([&] (unsigned long version, const json& delta) {
+      // Commits arrive one at a time, in order
+      ASSERT_EQ (published + 1, version);
+      published = version;
+    });
+
+    std::atomic<bool> ordered {true};
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < threads; ++thread)
+    {
+      workers.emplace_back ([&, thread] () {
+        unsigned long lastVersion = 0;
+        for (int i = 0; i < operationsPerThread; ++i)
+        {
+          // One write for every nine reads, like a browser polling pages
+          if (i % 10 == 0)
+          {
+            std::string name = "c" + std::to_string (thread) + "_" + std::to_string (i);
+            model.write ([&] (UMLData& data) {
+              data.addClass (name);
+              data.getClass (name).setX (i);
+              return json::object();
+            });
+          }
+          else
+          {
+            unsigned long version = model.read ([] (const UMLData& data, unsigned long version) {
+              // Every committed class is whole by the time a reader sees it
+              data.getJson().dump();
+              return version;
+            });
+            if (version < lastVersion)
+              ordered = false;
+            lastVersion = version;
+          }
+        }
+      });
+    }
+    for (std::thread& worker : workers)
+      worker.join();
+    double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - begin).count();
+
+    ASSERT_TRUE (ordered);
+    unsigned long writes = threads * operationsPerThread / 10;
+    ASSERT_EQ (writes, model.version());
+    ASSERT_EQ (writes, published);
+    model.read ([&] (const UMLData& data, unsigned long version) {
+      EXPECT_EQ (writes, data.getClasses().size());
+      return 0;
+    });
+    ::testing::Test::RecordProperty ("ops_per_second_" + std::to_string (threads) + "_threads",
+      std::to_string ((long) (threads * operationsPerThread / seconds)));
+  }
+}
+
+// Edits that throw or return null should leave the version alone
+TEST (UMLServerTest, SharedModelCommitTest)
+{
+  UMLSharedModel model;
+  json delta = model.write ([] (UMLData& data) {
+    data.addClass ("a");
+    return json {{"classes", json::array()}};
+  });
+  ASSERT_EQ (1, delta["version"]);
+  // Readers see a write as soon as it returns
+  model.read ([] (const UMLData& data, unsigned long version) {
+    EXPECT_EQ (1, version);
+    EXPECT_EQ (1, data.getClasses().size());
+    return 0;
+  });
+
+  ASSERT_THROW (model.write ([] (UMLData& data) {
+    data.addClass ("a");
+    return json::object();
+  }), std::runtime_error);
+  model.write ([] (UMLData& data) { return json(); });
+  ASSERT_EQ (1, model.version());
+
+  // An edit that throws partway is rolled back, so the next commit doesn't
+  // carry its half-made change
+  ASSERT_THROW (model.write ([] (UMLData& data) {
+    data.changeClassName ("a", "b");
+    data.getClass ("missing");
+    return json::object();
+  }), std::runtime_error);
+  model.write ([] (UMLData& data) {
+    data.addClass ("c");
+    return json::object();
+  });
+  ASSERT_EQ (2, model.version());
+  model.read ([] (const UMLData& data, unsigned long version) {
+    EXPECT_EQ (2, data.getClasses().size());
+    EXPECT_EQ ("a", data.getClasses().front().getName());
+    return 0;
+  });
+
+  // Undo is committed like any other change
+  model.undo ([] (UMLData& data) { return json::object(); });
+  ASSERT_EQ (3, model.version());
+  model.read ([] (const UMLData& data, unsigned long version) {
+    EXPECT_EQ (1, data.getClasses().size());
+    return 0;
+  });
+
+  // Stepping past either end of the history commits nothing
+  model.redo ([] (UMLData& data) { return json::object(); });
+  ASSERT_EQ (4, model.version());
+  ASSERT_TRUE (model.redo ([] (UMLData& data) { return json::object(); }).is_null());
+  ASSERT_EQ (4, model.version());
+  UMLSharedModel fresh;
+  ASSERT_TRUE (fresh.undo ([] (UMLData& data) { return json::object(); }).is_null());
+  ASSERT_EQ (0, fresh.version());
+}
+
+// Documents and sessions should be shared by name, and independent of each other
+TEST (UMLServerTest, DocumentStoreTest)
+{
+  UMLDocumentStore store ("documents_test");
+  auto first = store.document ("first");
+  ASSERT_EQ (first, store.document ("first"));
+  auto second = store.document ("second");
+  ASSERT_NE (first, second);
+
+  first->model.write ([] (UMLData& data) {
+    data.addClass ("a");
+    return json::object();
+  });
+  ASSERT_EQ (1, first->model.version());
+  ASSERT_EQ (0, second->model.version());
+  ASSERT_EQ (json ({"first", "second"}), store.listDocuments());
+
+  auto session = store.session ("one");
+  session->view["object"] = "class";
+  ASSERT_EQ (session, store.session ("one"));
+  ASSERT_EQ ("all", store.session ("two")->view["object"]);
+
+  ASSERT_TRUE (UMLDocumentStore::isValidName ("my_diagram2"));
+  ASSERT_FALSE (UMLDocumentStore::isValidName (""));
+  ASSERT_FALSE (UMLDocumentStore::isValidName ("../etc"));
+  ASSERT_NE (UMLDocumentStore::newSessionId(), UMLDocumentStore::newSessionId());
+  ASSERT_EQ (32, UMLDocumentStore::newSessionId().size());
+}
+
+// Idle documents over the memory budget should be written out and come back intact
+TEST (UMLServerTest, DocumentEvictionTest)
+{
+  std::filesystem::remove_all ("eviction_test");
+  {
+    // A budget of one byte evicts everything that isn't in use
+    UMLDocumentStore store ("eviction_test", 1);
+    auto busy = store.document ("busy");
+    {
+      auto idle = store.document ("idle");
+      idle->model.write ([] (UMLData& data) {
+        data.addClass ("a");
+        return json::object();
+      });
+      idle->model.write ([] (UMLData& data) {
+        data.addClass ("b");
+        return json::object();
+      });
+    }
+    store.document ("other");
+    ASSERT_EQ (1, store.metrics()["evictions"]);
+    ASSERT_TRUE (std::filesystem::exists ("eviction_test/idle.umldoc"));
+    ASSERT_EQ (json ({"busy", "idle", "other"}), store.listDocuments());
+
+    // Comes back with its version and history
+    auto idle = store.document ("idle");
+    ASSERT_EQ (1, store.metrics()["rehydrations"]);
+    ASSERT_EQ (2, idle->model.version());
+    idle->model.undo ([] (UMLData& data) { return json::object(); });
+    idle->model.read ([] (const UMLData& data, unsigned long version) {
+      EXPECT_EQ (1, data.getClasses().size());
+      return 0;
+    });
+    // Still in use, so never evicted
+    ASSERT_EQ (busy, store.document ("busy"));
+  }
+
+  {
+    // Documents written out and read back while other requests use them
+    // keep every edit
+    UMLDocumentStore store ("eviction_test", 1);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+      threads.emplace_back ([&store, i] {
+        for (int edit = 0; edit < 20; ++edit)
+        {
+          store.document ("shared")->model.write ([&] (UMLData& data) {
+            data.addClass ("c" + std::to_string (i) + "_" + std::to_string (edit));
+            return json::object();
+          });
+          store.document ("own" + std::to_string (i))->model.write ([&] (UMLData& data) {
+            data.addClass ("c" + std::to_string (edit));
+            return json::object();
+          });
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+    ASSERT_EQ (80, store.document ("shared")->model.version());
+    for (int i = 0; i < 4; ++i)
+      ASSERT_EQ (20, store.document ("own" + std::to_string (i))->model.version());
+  }
+  std::filesystem::remove_all ("eviction_test");
+}
+
+// Documents growing through edits should evict idle ones the next time they
+// are looked up, and a spool file that can't be read should be set aside
+TEST (UMLServerTest, DocumentGrowthTest)
+{
+  std::filesystem::remove_all ("growth_test");
+  {
+    UMLDocumentStore store ("growth_test", 1024 * 1024);
+    store.document ("idle")->model.write ([] (UMLData& data) {
+      data.addClass ("a");
+      return json::object();
+    });
+    auto growing = store.document ("growing");
+    growing->model.write ([] (UMLData& data) {
+      for (int i = 0; i < 5000; ++i)
+        data.addClass ("class" + std::to_string (i));
+      return json::object();
+    });
+    ASSERT_EQ (0, store.metrics()["evictions"]);
+    store.document ("growing");
+    ASSERT_EQ (1, store.metrics()["evictions"]);
+    ASSERT_TRUE (std::filesystem::exists ("growth_test/idle.umldoc"));
+
+    std::ofstream ("growth_test/broken.umldoc") << "not msgpack";
+    auto broken = store.document ("broken");
+    ASSERT_EQ (0, broken->model.version());
+    ASSERT_EQ (1, store.metrics()["quarantined"]);
+    ASSERT_TRUE (std::filesystem::exists ("growth_test/broken.umldoc.corrupt"));
+    ASSERT_EQ (broken, store.document ("broken"));
+  }
+  std::filesystem::remove_all ("growth_test");
+}
+
+// Documents in memory and sessions should be capped, and idle sessions
+// forgotten
+TEST (UMLServerTest, DocumentLimitsTest)
+{
+  std::filesystem::remove_all ("limits_test");
+  {
+    UMLDocumentStore store ("limits_test", UMLDocumentStore::DEFAULT_BUDGET, 2, 2, std::chrono::milliseconds (100));
+    auto first = store.document ("first");
+    auto second = store.document ("second");
+    // Both in use, so there is no room for a third
+    ASSERT_THROW (store.document ("third"), std::runtime_error);
+    // An idle one makes room, and is dropped without a file as it was never edited
+    second.reset();
+    store.document ("third");
+    ASSERT_EQ (2, store.metrics()["resident_documents"]);
+    ASSERT_FALSE (std::filesystem::exists ("limits_test/second.umldoc"));
+
+    // Sessions past the limit are forgotten, least recently used first
+    store.session ("a")->view["object"] = "class";
+    store.session ("b");
+    store.session ("a");
+    store.session ("c");
+    ASSERT_EQ (2, store.metrics()["sessions"]);
+    ASSERT_EQ ("class", store.session ("a")->view["object"]);
+
+    // As are sessions left unused past the timeout
+    std::this_thread::sleep_for (std::chrono::milliseconds (150));
+    ASSERT_EQ ("all", store.session ("a")->view["object"]);
+    ASSERT_EQ (1, store.metrics()["sessions"]);
+  }
+  std::filesystem::remove_all ("limits_test");
+}
+
+// A batch should apply every operation, or none of them
+TEST (UMLServerTest, BatchTest)
+{
+  UMLData data;
+  json outcome = UMLServer::applyBatch (data, json::parse (R"([
+    {"op": "add_class", "name": "a"},
+    {"op": "add_class", "name": "b"},
+    {"op": "add_field", "class": "a", "name": "x", "type": "int"},
+    {"op": "add_method", "class": "a", "name": "f", "return_type": "void", "params": [{"name": "p", "type": "int"}]},
+    {"op": "add_relationship", "source": "a", "destination": "b", "type": "composition"},
+    {"op": "move_class", "class": "b", "position_x": 10, "position_y": 20}
+  ])"));
+  ASSERT_TRUE (outcome["ok"]);
+  ASSERT_EQ (6, outcome["results"].size());
+  ASSERT_EQ (2, data.getClasses().size());
+  ASSERT_EQ (2, data.getClassAttributes ("a").size());
+  ASSERT_EQ (10, data.getClass ("b").getX());
+
+  // Fails at the second operation, the first is undone
+  json before = data.getJson();
+  outcome = UMLServer::applyBatch (data, json::parse (R"([
+    {"op": "add_class", "name": "c"},
+    {"op": "delete_class", "class": "missing"},
+    {"op": "add_class", "name": "d"}
+  ])"));
+  ASSERT_FALSE (outcome["ok"]);
+  ASSERT_EQ (1, outcome["failed"]);
+  ASSERT_TRUE (outcome["results"][0]["ok"]);
+  ASSERT_EQ ("Class not found", outcome["results"][1]["error"]);
+  ASSERT_TRUE (outcome["results"][2]["skipped"]);
+  ASSERT_EQ (before, data.getJson());
+
+  outcome = UMLServer::applyBatch (data, json::parse (R"([{"op": "explode"}])"));
+  ASSERT_FALSE (outcome["ok"]);
+  ASSERT_EQ (before, data.getJson());
+}
+
+// Indexed json should be getJson plus each attribute's id
+TEST (UMLServerTest, IndexedJsonTest)
+{
+  UMLData data;
+  data.addClass ("a");
+  data.addClass ("b");
+  data.addClassAttribute ("a", std::make_shared<UMLMethod> ("f", "void", std::list<UMLParameter>{}));
+  data.addClassAttribute ("a", std::make_shared<UMLField> ("x", "int"));
+  data.addClassAttribute ("a", std::make_shared<UMLMethod> ("f", "void", std::list<UMLParameter>{UMLParameter ("p", "int")}));
+  // Each class hands out its own ids
+  data.addClassAttribute ("b", std::make_shared<UMLField> ("x", "int"));
+  data.addRelationship ("a", "b", 0);
+
+  json j = UMLServer::indexedJson (data);
+  ASSERT_EQ (1, j["classes"][0]["methods"][0]["id"]);
+  ASSERT_EQ (3, j["classes"][0]["methods"][1]["id"]);
+  ASSERT_EQ (2, j["classes"][0]["fields"][0]["id"]);
+  ASSERT_EQ (1, j["classes"][1]["fields"][0]["id"]);
+
+  for (json& uclass : j["classes"])
+  {
+    for (json& field : uclass["fields"])
+      field.erase ("id");
+    for (json& method : uclass["methods"])
+      method.erase ("id");
+  }
+  ASSERT_EQ (data.getJson(), j);
+}
+
+// Gzip should round trip, and only be used when the client allows it
+TEST (UMLServerTest, CompressionTest)
+{
+  std::string body;
+  for (int i = 0; i < 1000; ++i)
+    body += "{\"name\": \"class" + std::to_string (i) + "\", \"fields\": []},";
+  std::string gzipped = UMLCompression::gzip (body);
+  ASSERT_LT (gzipped.size(), body.size() / 4);
+  ASSERT_EQ (body, UMLCompression::gunzip (gzipped));
+  ASSERT_EQ ("", UMLCompression::gunzip (UMLCompression::gzip ("")));
+  ASSERT_THROW (UMLCompression::gunzip ("not gzip"), std::runtime_error);
+
+  ASSERT_TRUE (UMLCompression::acceptsGzip ("gzip, deflate, br"));
+  ASSERT_TRUE (UMLCompression::acceptsGzip ("deflate, GZIP;q=0.5"));
+  ASSERT_TRUE (UMLCompression::acceptsGzip ("*"));
+  ASSERT_FALSE (UMLCompression::acceptsGzip (""));
+  ASSERT_FALSE (UMLCompression::acceptsGzip ("deflate, br"));
+  ASSERT_FALSE (UMLCompression::acceptsGzip ("gzip;q=0"));
+
+  // Large pages carry a gzip copy, small ones don't bother
+  UMLPageCache pages;
+  ASSERT_EQ (body, UMLCompression::gunzip (pages.store ("big", 1, body)->gzipped));
+  ASSERT_EQ ("", pages.store ("small", 1, "<html></html>")->gzipped);
+}
+
+// Static files should be compressed when loaded, and only files in the
+// directory served
+TEST (UMLServerTest, StaticAssetsTest)
+{
+  std::filesystem::create_directory ("assets_test");
+  std::string script (5000, 'a');
+  std::ofstream ("assets_test/big.js") << script;
+  std::ofstream ("assets_test/small.css") << "body {}";
+  {
+    UMLStaticAssets assets;
+    assets.load ("assets_test");
+    auto big = assets.find ("big.js");
+    ASSERT_NE (nullptr, big);
+    ASSERT_EQ ("application/javascript", big->type);
+    ASSERT_EQ (script, UMLCompression::gunzip (big->gzipped));
+    auto small = assets.find ("small.css");
+    ASSERT_EQ ("text/css", small->type);
+    ASSERT_EQ ("body {}", small->body);
+    ASSERT_EQ ("", small->gzipped);
+    ASSERT_EQ (nullptr, assets.find ("missing.js"));
+    ASSERT_EQ (nullptr, assets.find ("../Tests.cpp"));
+  }
+  std::filesystem::remove_all ("assets_test");
+}
+
+// The static files and templates should be built into the program, and
+// served from there unless in dev mode
+TEST (UMLServerTest, EmbeddedFilesTest)
+{
+  const UMLEmbeddedFile* page = UMLEmbeddedFiles::find ("templates/index.html");
+  ASSERT_NE (nullptr, page);
+  ASSERT_EQ (page->size, page->contents().size());
+  ASSERT_NE (std::string::npos, page->contents().find ("<html"));
+  ASSERT_EQ (nullptr, UMLEmbeddedFiles::find ("templates/missing.html"));
+
+  UMLStaticAssets assets;
+  assets.load ("static");
+  auto script = assets.find ("svg.js");
+  ASSERT_NE (nullptr, script);
+  ASSERT_EQ (UMLEmbeddedFiles::find ("static/svg.js")->etag, script->etag);
+  ASSERT_EQ (script->body, UMLCompression::gunzip (script->gzipped));
+  ASSERT_EQ ("public, max-age=300", script->cacheControl);
+}
+
+// Metrics should be registered once, and written in Prometheus' format
+TEST (UMLServerTest, MetricsTest)
+{
+  UMLMetrics metrics;
+  UMLCounter& requests = metrics.counter ("requests_total", "Requests", "route=\"/\"");
+  ASSERT_EQ (&requests, &metrics.counter ("requests_total", "Requests", "route=\"/\""));
+  ASSERT_THROW (metrics.gauge ("requests_total", "Requests"), std::runtime_error);
+  requests.add();
+  requests.add (2);
+  metrics.gauge ("depth", "Depth").set (1.5);
+
+  UMLHistogram& latency = metrics.histogram ("latency_seconds", "Latency", "", {0.1, 1});
+  latency.observe (0.05);
+  latency.observe (0.1);
+  latency.observe (0.5);
+  latency.observe (3);
+  ASSERT_EQ (4, latency.getCount());
+  ASSERT_DOUBLE_EQ (3.65, latency.getSum());
+
+  std::string text = metrics.exposition();
+  ASSERT_NE (std::string::npos, text.find ("# TYPE requests_total counter\nrequests_total{route=\"/\"} 3\n"));
+  ASSERT_NE (std::string::npos, text.find ("depth 1.5\n"));
+  ASSERT_NE (std::string::npos, text.find ("latency_seconds_bucket{le=\"0.1\"} 2\n"));
+  ASSERT_NE (std::string::npos, text.find ("latency_seconds_bucket{le=\"1\"} 3\n"));
+  ASSERT_NE (std::string::npos, text.find ("latency_seconds_bucket{le=\"+Inf\"} 4\n"));
+  ASSERT_NE (std::string::npos, text.find ("latency_seconds_count 4\n"));
+  ASSERT_EQ ("\"a\\\"b\"", UMLMetrics::label ("a\"b"));
+  ASSERT_EQ ("1234567", UMLMetrics::number (1234567));
+
+  // The model's own metrics go to the global registry
+  UMLHistogram& saves = UMLMetrics::global().histogram ("uml_history_save_seconds", "");
+  unsigned long before = saves.getCount();
+  UMLData data;
+  UMLDataHistory history (data);
+  history.save (data);
+  ASSERT_EQ (before + 1, saves.getCount());
+}
+
+// ****************************************************
+
+/*
+////////////////////////////////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+|**************************************************************|
+|                      Tests for UMLTrace                      |
+|**************************************************************|
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\////////////////////////////////
+*/
+
+// Model edits should leave spans in the trace when tracing is built in,
+// and nothing otherwise. New threads should reuse the buffers of exited ones.
+TEST (UMLTraceTest, TraceTest)
+{
+  UMLData data;
+  data.addClass ("traced");
+  std::thread other ([] {
+    UMLData data;
+    data.addClass ("elsewhere");
+  });
+  other.join();
+
+  json trace = UMLTrace::global().dump();
+  ASSERT_TRUE (trace["traceEvents"].is_array());
+  std::set<unsigned long> threads;
+  bool found = false;
+  for (const json& event : trace["traceEvents"])
+  {
+    ASSERT_EQ ("X", event["ph"]);
+    ASSERT_GE (event["dur"].get<double>(), 0);
+    threads.insert (event["tid"].get<unsigned long>());
+    found = found || event["name"] == "UMLData::addClass";
+  }
+  ASSERT_EQ (UMLTrace::enabled(), found);
+  if (UMLTrace::enabled())
+    ASSERT_GE (threads.size(), 2);
+
+  // Threads that have exited hand their buffer to the next thread, so
+  // threads run one after another share at most one new buffer
+  size_t buffers = UMLTrace::global().bufferCount();
+  for (int i = 0; i < 5; ++i)
+  {
+    std::thread ([] {
+      UMLTrace::global().record ("short_lived", 0, 1);
+    }).join();
+  }
+  ASSERT_LE (UMLTrace::global().bufferCount(), buffers + 1);
+}
+
+// ****************************************************
+
+/*
+////////////////////////////////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+|**************************************************************|
+|           Tests for UMLGenerator and UMLSaveWriter           |
+|**************************************************************|
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\////////////////////////////////
+*/
+
+// Generated diagrams should depend only on their options, and be the same
+// whether built as a model or streamed out as a save
+TEST (UMLGeneratorTest, GeneratorTest)
+{
+  UMLGeneratorOptions options;
+  options.classes = 200;
+  options.overloadDensity = 0.5;
+  options.shape = UMLGraphShape::scaleFree;
+  std::ostringstream first, second;
+  UMLGenerator (options).write (first);
+  UMLGenerator (options).write (second);
+  ASSERT_EQ (first.str(), second.str());
+
+  json written = json::parse (first.str());
+  ASSERT_EQ (200, written["class_count"]);
+  written.erase ("class_count");
+  ASSERT_EQ (written, UMLGenerator (options).generate().getJson());
+
+  options.seed = 2;
+  std::ostringstream reseeded;
+  UMLGenerator (options).write (reseeded);
+  ASSERT_NE (first.str(), reseeded.str());
+
+  options.shape = UMLGraphShape::tree;
+  ASSERT_EQ (199, UMLGenerator (options).generate().getRelationships().size());
+
+  ERR_CHECK (UMLGenerator::shapeFromString ("ring"), "Unknown graph shape");
+  options.minFields = 7;
+  ERR_CHECK (UMLGenerator {options}, "Minimum is greater than maximum");
+}
+
+// The save writer should write what json::dump would, and hold callers to
+// the class count it was given
+TEST (UMLSaveWriterTest, SaveWriterTest)
+{
+  json uclass = {{"name", "A"}, {"position_x", 0}, {"position_y", 0}, {"fields", json::array()}, {"methods", json::array()}};
+  json relationship = {{"source", "A"}, {"destination", "A"}, {"type", "aggregation"}};
+  std::ostringstream out;
+  UMLSaveWriter writer (out, 1);
+  writer.addClass (uclass);
+  writer.addRelationship (relationship);
+  writer.finish();
+  json expected = {{"class_count", 1}, {"classes", {uclass}}, {"relationships", {relationship}}};
+  ASSERT_EQ (expected.dump(), out.str());
+
+  std::ostringstream empty;
+  UMLSaveWriter short_ (empty, 2);
+  short_.addClass (uclass);
+  ERR_CHECK (short_.finish(), "Fewer classes written than the save's class count");
+  UMLSaveWriter over (empty, 0);
+  ERR_CHECK (over.addClass (uclass), "More classes written than the save's class count");
+}
+
+// ****************************************************
+
+/*
+////////////////////////////////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+|**************************************************************|
+|                  Tests for UMLLoadGenerator                  |
+|**************************************************************|
+\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\////////////////////////////////
+*/
+
+// Load plans should split the requests between workers and be the same
+// every time for a seed
+TEST (UMLLoadGeneratorTest, LoadGeneratorTest)
+{
+  UMLLoadOptions options;
+  options.workers = 3;
+  options.requests = 301;
+  vector<UMLLoadRequest> first = UMLLoadGenerator (options).plan (0);
+  vector<UMLLoadRequest> again = UMLLoadGenerator (options).plan (0);
+  ASSERT_EQ (101, first.size());
+  ASSERT_EQ (100, UMLLoadGenerator (options).plan (2).size());
+  ASSERT_EQ ("/delete/class/Load0", first[0].path);
+  ASSERT_EQ ("/add/class?cname=Load0", first[1].path);
+  std::set<string> routes;
+  for (size_t i = 0; i < first.size(); ++i)
+  {
+    ASSERT_EQ (first[i].path, again[i].path);
+    routes.insert (first[i].route);
+  }
+  ASSERT_GE (routes.size(), 5);
+
+  options.seed = 2;
+  vector<UMLLoadRequest> reseeded = UMLLoadGenerator (options).plan (0);
+  bool differs = false;
+  for (size_t i = 0; i < first.size(); ++i)
+    differs = differs || first[i].path != reseeded[i].path;
+  ASSERT_TRUE (differs);
+
+  vector<double> latencies;
+  for (int i = 1; i <= 1000; ++i)
+    latencies.push_back (i);
+  ASSERT_EQ (500, UMLLoadGenerator::percentile (latencies, 0.5));
+  ASSERT_EQ (990, UMLLoadGenerator::percentile (latencies, 0.99));
+  ASSERT_EQ (999, UMLLoadGenerator::percentile (latencies, 0.999));
+  ASSERT_EQ (0, UMLLoadGenerator::percentile ({}, 0.5));
+
+  options.workers = 0;
+  ERR_CHECK (UMLLoadGenerator {options}, "At least one worker is needed");
+}
@@ -0,0 +1,43 @@
+# Writes a C++ source holding the contents of files, so the server can run
+# without reading them from disk. Run in script mode:
+#   cmake -DROOT=<dir> -DFILES=<a|b|c> -DOUTPUT=<file.cpp> -P EmbedFiles.cmake
+# FILES are relative to ROOT and are embedded under those relative names.
+
+string(REPLACE "|" ";" FILES "${FILES}")
+
+set(arrays "")
+set(entries "")
+set(index 0)
+foreach(name IN LISTS FILES)
+  file(READ "${ROOT}/${name}" hex HEX)
+  string(LENGTH "${hex}" size)
+  math(EXPR size "${size} / 2")
+  file(SHA1 "${ROOT}/${name}" hash)
+  string(SUBSTRING "${hash}" 0 16 hash)
+
+  # 32 bytes per line, each as 0x.., then a terminating zero so the array
+  # is never empty and the contents can be read as a C string
+  string(REGEX REPLACE "(................................................................)" "\\1\n  " hex "${hex}")
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," hex "${hex}")
+  string(APPEND arrays "// ${name}\nstatic const unsigned char file${index}[] = {\n  ${hex}0x00\n};\n\n")
+  string(APPEND entries "    {\"${name}\", file${index}, ${size}, \"\\\"${hash}\\\"\"},\n")
+  math(EXPR index "${index} + 1")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated by cmake/EmbedFiles.cmake, do not edit\n\
+#include \"UMLEmbeddedFiles.hpp\"\n\
+\n\
+${arrays}\
+// Every embedded file\n\
+const std::vector<UMLEmbeddedFile>& UMLEmbeddedFiles::all()\n\
+{\n\
+  static const std::vector<UMLEmbeddedFile> files = {\n\
+${entries}\
+  };\n\
+  return files;\n\
+}\n")
+
+# Only touch the output when it changed, so unchanged files don't rebuild
+configure_file("${OUTPUT}.tmp" "${OUTPUT}" COPYONLY)
+file(REMOVE "${OUTPUT}.tmp")
@@ -14,6 +14,8 @@
 #include "umllib/include/UMLMethod.hpp"
 #include "umllib/include/UMLParameter.hpp"
 #include "umllib/include/UMLServer.hpp"
+#include <fstream>
+#include <iostream>
 #include <memory>
 //--------------------------------------------------------------------
 
@@ -24,7 +26,30 @@ int main(int argc, char** argv)
         if (string(argv[1]) == "--cli") {
           UMLCLI newInterface;
           newInterface.start();
-      }
+        }
+        // GUI that reloads templates when they are edited
+        else if (string(argv[1]) == "--dev") {
+          UMLServer newServer(true);
+          newServer.start(60555);
+        }
+        // Runs CLI commands from a file, or stdin without one, and prints
+        // a line of json for each
+        else if (string(argv[1]) == "--script") {
+          std::ios::sync_with_stdio(false);
+          UMLCLI interface;
+          int failures;
+          if (argc > 2) {
+            std::ifstream script(argv[2]);
+            if (!script) {
+              std::cerr << "Could not open " << argv[2] << "\n";
+              return 1;
+            }
+            failures = interface.run_script(script, std::cout);
+          } else {
+            failures = interface.run_script(std::cin, std::cout);
+          }
+          return failures == 0 ? 0 : 1;
+        }
     } else {
       UMLServer newServer;
       newServer.start(60555);
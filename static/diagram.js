@@ -2,10 +2,15 @@ var boxes = new Map();
 var lines = new Array();
 var relBox = new Array();
 var classesJson;
-var json_string;
 var relationshipsJson;
+var modelVersion = 0;
+var diagram;
+//changes that arrived ahead of one still in flight, keyed by version
+var pendingDeltas = new Map();
+var resyncTimer = null;
 SVG.on(document, 'DOMContentLoaded', function() {
   var draw = SVG().addTo('svg');
+  diagram = draw;
 
   //add panning and zooming
   svgPanZoom('#umldiagram', {
@@ -36,6 +41,8 @@ SVG.on(document, 'DOMContentLoaded', function() {
 
   drawLines(draw);
   //drawRelBox(draw);
+
+  subscribeChanges();
 })
 
 //draw relationship lines
@@ -246,25 +253,9 @@ function createClassBox(draw, uclass, x, y)
     else if(nested.x() > 3000){
       nested.x(2700);
     }
-    //send position to server
-    request = new XMLHttpRequest();
-    request.open("GET", '/position/' + uclass["name"] + '/' + Math.floor(nested.x()) + '/' + Math.floor(nested.y(), true));
-    request.send();
-
-    //get new json string for saving
-    var json_string_request = new XMLHttpRequest;
-    json_string_request.open('GET', '/save/data');
-    
-    // If specified, responseType must be empty string or "document"
-    json_string_request.responseType = 'text';
-    
-    json_string_request.onload = function () {
-      if (json_string_request.readyState === json_string_request.DONE && json_string_request.status === 200) {
-        json_string = json_string_request.responseText;
-      }
-    };
-    
-    json_string_request.send();
+    //send position to server, the reply only holds this class
+    apiRequest("PATCH", "/api/v1/classes/" + uclass["name"],
+      { position_x: Math.floor(nested.x()), position_y: Math.floor(nested.y()) });
 
     //draw the relationship lines after each drag
     drawLines(draw);
@@ -283,11 +274,179 @@ function createClassBox(draw, uclass, x, y)
     
 }
 
-function sendDiagramInfo(classes_in, relationships_in, json_string_in)
+function sendDiagramInfo(classes_in, relationships_in, version_in)
 {
   classesJson = classes_in;
   relationshipsJson = relationships_in;
-  json_string = JSON.stringify(json_string_in);
+  modelVersion = version_in;
+}
+
+//send an edit to the json api and apply the entities it sends back
+function apiRequest(method, path, body, onDone)
+{
+  var request = new XMLHttpRequest();
+  request.open(method, path);
+  request.setRequestHeader("Content-Type", "application/json");
+  request.onload = function () {
+    var reply = JSON.parse(request.responseText);
+    if (request.status === 200) {
+      applyDelta(reply);
+    } else {
+      console.log(reply["error"]);
+    }
+    if (onDone) {
+      onDone(request.status, reply);
+    }
+  };
+  request.send(body === undefined ? "" : JSON.stringify(body));
+}
+
+//listen for changes made elsewhere (other tabs, scripts) and apply them
+function subscribeChanges()
+{
+  if (!window.EventSource) {
+    return;
+  }
+  var source = new EventSource("/api/v1/events?since=" + modelVersion);
+  source.addEventListener("delta", function (e) {
+    applyDelta(JSON.parse(e.data));
+  });
+  //fell too far behind for the server to replay, start over from the whole model
+  source.addEventListener("reset", function (e) {
+    reloadModel();
+  });
+}
+
+//fetch the whole model and redraw from it
+function reloadModel()
+{
+  var request = new XMLHttpRequest();
+  request.open("GET", "/api/v1/model");
+  request.onload = function () {
+    if (request.status === 200) {
+      applyDelta(JSON.parse(request.responseText));
+    }
+  };
+  request.send();
+}
+
+//patch the diagram with a change from the server instead of reloading the page
+function applyDelta(delta)
+{
+  var version = delta["version"];
+  //already have this change
+  if (version <= modelVersion) {
+    return;
+  }
+  //a change before this one hasn't arrived yet, hold this one until it does
+  if (version > modelVersion + 1 && !delta["full"]) {
+    pendingDeltas.set(version, delta);
+    if (resyncTimer === null) {
+      resyncTimer = setTimeout(function () {
+        resyncTimer = null;
+        if (pendingDeltas.size > 0) {
+          reloadModel();
+        }
+      }, 2000);
+    }
+    return;
+  }
+  modelVersion = version;
+
+  if (delta["full"]) {
+    boxes.forEach(function (box) {
+      box.remove();
+    });
+    boxes.clear();
+    classesJson = [];
+    relationshipsJson = [];
+  }
+
+  var deleted = delta["deleted"] || {};
+  (deleted["classes"] || []).forEach(function (name) {
+    removeClassBox(name);
+    classesJson = classesJson.filter(uclass => uclass["name"] != name);
+  });
+  (deleted["relationships"] || []).forEach(function (rel) {
+    relationshipsJson = relationshipsJson.filter(r =>
+      !(r["source"] == rel["source"] && r["destination"] == rel["destination"]));
+  });
+
+  (delta["classes"] || []).forEach(function (uclass) {
+    var index = classesJson.findIndex(c => c["name"] == uclass["name"]);
+    var old = index >= 0 ? classesJson[index] : null;
+    if (index >= 0) {
+      classesJson[index] = uclass;
+    } else {
+      classesJson.push(uclass);
+    }
+    //only moved, keep the box and just reposition it
+    if (old && boxes.has(uclass["name"]) && sameContents(old, uclass)) {
+      boxes.get(uclass["name"]).x(uclass["position_x"]).y(uclass["position_y"]);
+      return;
+    }
+    removeClassBox(uclass["name"]);
+    createClassBox(diagram, uclass, uclass["position_x"], uclass["position_y"]);
+  });
+
+  (delta["relationships"] || []).forEach(function (rel) {
+    var index = relationshipsJson.findIndex(r =>
+      r["source"] == rel["source"] && r["destination"] == rel["destination"]);
+    if (index >= 0) {
+      relationshipsJson[index] = rel;
+    } else {
+      relationshipsJson.push(rel);
+    }
+  });
+
+  drawLines(diagram);
+
+  //anything held back is either stale now or next in line
+  pendingDeltas.forEach(function (pending, pendingVersion) {
+    if (pendingVersion <= modelVersion) {
+      pendingDeltas.delete(pendingVersion);
+    }
+  });
+  var next = pendingDeltas.get(modelVersion + 1);
+  if (next) {
+    pendingDeltas.delete(modelVersion + 1);
+    applyDelta(next);
+  }
+}
+
+//true if two classes only differ in position
+function sameContents(a, b)
+{
+  return a["name"] == b["name"]
+    && JSON.stringify(a["fields"]) == JSON.stringify(b["fields"])
+    && JSON.stringify(a["methods"]) == JSON.stringify(b["methods"]);
+}
+
+function removeClassBox(name)
+{
+  if (boxes.has(name)) {
+    boxes.get(name).remove();
+    boxes.delete(name);
+  }
+}
+
+//save file contents, built from the copy of the model the deltas keep up to
+//date rather than fetched after every change. The api adds ids to fields and
+//methods, which saves don't have.
+function saveData()
+{
+  var withoutId = function (attr) {
+    var copy = Object.assign({}, attr);
+    delete copy["id"];
+    return copy;
+  };
+  var classes = classesJson.map(function (uclass) {
+    var copy = Object.assign({}, uclass);
+    copy["fields"] = uclass["fields"].map(withoutId);
+    copy["methods"] = uclass["methods"].map(withoutId);
+    return copy;
+  });
+  return JSON.stringify({"classes": classes, "relationships": relationshipsJson});
 }
 
 function getDiagramImage()
@@ -309,7 +468,7 @@ function save()
   document.addEventListener('DOMContentLoaded', function () {
     alert("page loaded");
   });
-  window.onload = download('data:text/plain;charset=utf-8,' + encodeURIComponent(json_string), "diagram.json");
+  window.onload = download('data:text/plain;charset=utf-8,' + encodeURIComponent(saveData()), "diagram.json");
 }
 
 function download(file, name)
@@ -22,7 +22,7 @@ UMLAttribute::UMLAttribute(string newName, string newType)
 }
 
 // Grab name of the given attribute
-string UMLAttribute::getAttributeName() const
+const string& UMLAttribute::getAttributeName() const
 {
 	return name;
 }
@@ -34,7 +34,7 @@ void UMLAttribute::changeName(string newName)
 }
 
 // Grab type of the given attribute
-string UMLAttribute::getType() const
+const string& UMLAttribute::getType() const
 {
 	return type;
 }
@@ -49,4 +49,22 @@ void UMLAttribute::changeType(string newType)
 string UMLAttribute::identifier() const
 {
 	return "attribute";
+}
+
+// Grab the id of the given attribute
+unsigned long UMLAttribute::getId() const
+{
+	return id;
+}
+
+// Set the id of the given attribute, done by the class holding it
+void UMLAttribute::setId(unsigned long newId)
+{
+	id = newId;
+}
+
+// Returns a separate copy of the attribute, id included
+std::shared_ptr<UMLAttribute> UMLAttribute::clone() const
+{
+	return std::make_shared<UMLAttribute>(*this);
 }
\ No newline at end of file
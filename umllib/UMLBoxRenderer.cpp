@@ -0,0 +1,162 @@
+/*
+  Filename   : UMLBoxRenderer.cpp
+  Description: Implementation of the CLI's box renderer.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLBoxRenderer.hpp"
+
+#include <algorithm>
+//--------------------------------------------------------------------
+
+// Overload number of each of the class's attributes, in order. Methods
+// are numbered from 1 among the methods sharing their name, fields get 0.
+vector<int> UMLBoxRenderer::overloadNumbers(const UMLClass& uclass)
+{
+  const auto& attributes = uclass.getAttributes();
+  vector<int> result;
+  result.reserve(attributes.size());
+  for (const auto& attribute : attributes)
+    result.push_back(uclass.getOverloadNumber(*attribute));
+  return result;
+}
+
+// Draws a class as a box of its name, fields and methods. The content
+// lines are built first so the width is known before any row is drawn.
+void UMLBoxRenderer::renderClass(const UMLClass& uclass)
+{
+  const string& name = uclass.getName();
+  const auto& attributes = uclass.getAttributes();
+  numbers = overloadNumbers(uclass);
+  lines.clear();
+  lineEnds.clear();
+
+  // Fields are listed before methods
+  for (const auto& attribute : attributes)
+  {
+    if (attribute->identifier() != "field")
+      continue;
+    lines += ' ';
+    lines += attribute->getAttributeName();
+    lines += " : ";
+    lines += attribute->getType();
+    lines += ' ';
+    lineEnds.push_back(lines.size());
+  }
+  size_t fieldLines = lineEnds.size();
+
+  for (size_t i = 0; i < attributes.size(); ++i)
+  {
+    if (attributes[i]->identifier() != "method")
+      continue;
+    lines += ' ';
+    appendSignature(lines, static_cast<const UMLMethod&>(*attributes[i]), numbers[i]);
+    lines += ' ';
+    lineEnds.push_back(lines.size());
+  }
+
+  size_t width = name.size() + 2;
+  size_t start = 0;
+  for (size_t end : lineEnds)
+  {
+    width = std::max(width, end - start);
+    start = end;
+  }
+
+  appendEdge(width);
+  buffer += "| ";
+  buffer += name;
+  buffer.append(width - name.size() - 2, ' ');
+  buffer += " |\n";
+  appendEdge(width);
+
+  start = 0;
+  for (size_t i = 0; i < lineEnds.size(); ++i)
+  {
+    appendRow(lines.data() + start, lineEnds[i] - start, width);
+    start = lineEnds[i];
+    // Each non-empty section is closed off by an edge
+    if (i + 1 == fieldLines || i + 1 == lineEnds.size())
+      appendEdge(width);
+  }
+  buffer += '\n';
+}
+
+// Draws a single method line with its overload number
+void UMLBoxRenderer::renderMethod(const UMLMethod& method, int number)
+{
+  appendSignature(buffer, method, number);
+  buffer += " \n";
+}
+
+// Draws a relationship's type followed by the boxes of both classes
+void UMLBoxRenderer::renderRelationship(const UMLClass& source, const UMLClass& destination, const string& type)
+{
+  buffer += "TYPE: ";
+  buffer += type;
+  buffer += "\n\nSOURCE:\n";
+  renderClass(source);
+  buffer += "DESTINATION:\n";
+  renderClass(destination);
+}
+
+// Adds text as is
+void UMLBoxRenderer::append(const string& text)
+{
+  buffer += text;
+}
+
+// Writes everything rendered so far and empties the buffer. The buffer
+// keeps its capacity for the next render.
+void UMLBoxRenderer::flush(std::ostream& out)
+{
+  out.write(buffer.data(), buffer.size());
+  out.flush();
+  buffer.clear();
+}
+
+// Everything rendered since the last flush
+const string& UMLBoxRenderer::str() const
+{
+  return buffer;
+}
+
+// Appends "name(p : type, ...) : type [number]" for a method
+void UMLBoxRenderer::appendSignature(string& out, const UMLMethod& method, int number)
+{
+  out += method.getAttributeName();
+  out += '(';
+  bool first = true;
+  for (const auto& param : method.getParam())
+  {
+    if (!first)
+      out += ", ";
+    out += param.getName();
+    out += " : ";
+    out += param.getType();
+    first = false;
+  }
+  out += ") : ";
+  out += method.getType();
+  out += " [";
+  out += std::to_string(number);
+  out += ']';
+}
+
+// Appends a box row holding the given text, padded to the width
+void UMLBoxRenderer::appendRow(const char* text, size_t length, size_t width)
+{
+  buffer += '|';
+  buffer.append(text, length);
+  buffer.append(width - length, ' ');
+  buffer += "|\n";
+}
+
+// Appends the edge of a box of the given width
+void UMLBoxRenderer::appendEdge(size_t width)
+{
+  buffer += '+';
+  buffer.append(width, '-');
+  buffer += "+\n";
+}
@@ -8,11 +8,12 @@
 #define ERR_CATCH(fun)                                  \
     try {                                               \
         fun;                                            \
-        History.save(Model);                            \
+        save_history();                                 \
     }                                                   \
     catch (const std::runtime_error& error) {           \
         cout << endl << error.what() << endl << endl;   \
         ErrorStatus = true;                             \
+        CommandFailed = true;                           \
     }
 /************************************************************/
 
@@ -22,7 +23,15 @@
 #include <cli/clilocalsession.h>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include "include/UMLCLI.hpp"
+#include "include/UMLListFilter.hpp"
+#include "include/UMLNameCompleter.hpp"
+#include "include/UMLSaveCatalog.hpp"
+#include "include/UMLTrace.hpp"
 //--------------------------------------------------------------------
 // Using declarations
 using namespace cli;
@@ -33,6 +42,9 @@ using namespace std;
     #define strcasecmp _stricmp
 #endif
 //--------------------------------------------------------------------
+// Script results are written out in blocks of about this many bytes
+static const size_t SCRIPT_BUFFER_SIZE = 1 << 16;
+//--------------------------------------------------------------------
 
 /*
 ////////////////////////////////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
@@ -94,6 +106,33 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out){ clear_selected_method(); redo(); },
     "Redo your most recently undone action. WARNING: Also clears your selected method.");
 
+  // Trace
+  rootMenu -> Insert(
+    "trace", {"file_name"},
+    [&](std::ostream& out, string fileName)
+    {
+      if (!UMLTrace::enabled())
+      {
+        out << "Tracing is off, rebuild with -DUML_TRACING=ON to record spans.\n";
+        return;
+      }
+      std::ofstream file(fileName + ".json");
+      file << UMLTrace::global().dump();
+      file.close();
+      if (!file)
+      {
+        CommandFailed = true;
+        out << "Error! Could not write \"" << fileName << ".json\".\n";
+      }
+    },
+    "Enter a file name (no file extension) to write the spans recorded so far as a Chrome trace, which chrome://tracing can open.");
+
+  // Stats
+  rootMenu -> Insert(
+    "stats",
+    [&](std::ostream& out){ show_stats(); },
+    "Shows how many classes, attributes and relationships your diagram has, and roughly how much memory it and its undo history take up.");
+
 
   //--------------------------------------------------------------------
 
@@ -110,9 +149,10 @@ Cli UMLCLI::cli_menu()
 
   // List Classes
   classMenu -> Insert(
-    "list",
-    [&](std::ostream& out){ list_classes(); },
-    "Lists all classes the user has created, as well as their attributes.");
+    "list", {"options"},
+    [&](std::ostream& out, std::vector<string> options){ list_classes(options); },
+    "Lists all classes the user has created, as well as their attributes. Takes --name <prefix or glob>, "
+    "--member-type <type>, --page <number>, --page-size <number> and --count.");
 
   // View Class
   classMenu -> Insert(
@@ -120,15 +160,12 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string className)
     {
       if(Model.doesClassExist(className)) // Check if class exists
+        display_class(Model.getClass(className));
+      else
       {
-        for(auto currentClass : Model.getClasses()) // Find UMLClass from the string name
-          if(currentClass.getName() == className)
-          {
-            display_class(currentClass);
-            break;
-          }
+        CommandFailed = true;
+        out << "Class does not exist\n";
       }
-      else out << "Class does not exist\n";
     },
     "List information about a given class.");
   
@@ -176,9 +213,10 @@ Cli UMLCLI::cli_menu()
 
   // List Relationships
   relationshipMenu -> Insert(
-    "list",
-    [&](std::ostream& out){ list_relationships(); },
-    "Lists all relationships created by the user. (e.g. [source -> destination])");
+    "list", {"options"},
+    [&](std::ostream& out, std::vector<string> options){ list_relationships(options); },
+    "Lists all relationships created by the user. (e.g. [source -> destination]) Takes --name <prefix or glob>, "
+    "--type <relship_type>, --page <number>, --page-size <number> and --count.");
   
   // Add Relationship
   relationshipMenu -> Insert(
@@ -230,6 +268,7 @@ Cli UMLCLI::cli_menu()
         add_field(className, fieldName, fieldType);
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot add field.\n";
       };
     },
@@ -244,6 +283,7 @@ Cli UMLCLI::cli_menu()
         delete_field(className, fieldName);
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot delete field.\n";
       };
     },
@@ -258,6 +298,7 @@ Cli UMLCLI::cli_menu()
         rename_field(className, fieldName, newFieldName);
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot rename field.\n";
       };
     },
@@ -272,6 +313,7 @@ Cli UMLCLI::cli_menu()
         change_field(className, fieldName, newFieldType);
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot change field type.\n";
       };
     },
@@ -315,6 +357,7 @@ Cli UMLCLI::cli_menu()
         }
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot select method.\n";
       };
     },
@@ -326,6 +369,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot view selected method..\n";
       }
       else {
@@ -355,6 +399,7 @@ Cli UMLCLI::cli_menu()
         }
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot view methods.\n";
       };
     },
@@ -369,6 +414,7 @@ Cli UMLCLI::cli_menu()
         add_method(className, methodName, methodType);
       }
       else{
+        CommandFailed = true;
         out << "Class does not exist. Cannot add method.\n";
       };
     },
@@ -380,6 +426,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot delete method.\n";
       }
       else {
@@ -396,6 +443,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string newMethodName)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot rename method.\n";
       }
       else {
@@ -410,6 +458,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string newMethodType)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot change method type.\n";
       }
       else {
@@ -439,6 +488,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string paramType, string paramName)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot add parameter.\n";
       }
       else {
@@ -453,6 +503,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string paramName)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot delete parameter.\n";
       }
       else {
@@ -467,6 +518,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string paramNameOld, string paramNameNew)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot rename parameter.\n";
       }
       else {
@@ -481,6 +533,7 @@ Cli UMLCLI::cli_menu()
     [&](std::ostream& out, string paramName, string newParamType)
     {
       if (!MethodSelected) {
+        CommandFailed = true;
         out << "No method selected. Cannot change parameter type.\n";
       }
       else {
@@ -491,6 +544,112 @@ Cli UMLCLI::cli_menu()
   
   
   
+  //--------------------------------------------------------------------
+
+  /*
+  ////////////////////////////////\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\
+  |**************************************************************|
+  |                          COMPLETION                          |
+  |**************************************************************|
+  \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\////////////////////////////////
+  */
+
+  // Values out of a fixed list that start with the prefix
+  auto matching = [](const vector<string>& values, const string& prefix)
+  {
+    vector<string> result;
+    for (const string& value : values)
+      if (value.compare(0, prefix.size(), prefix) == 0)
+        result.push_back(value);
+    return result;
+  };
+
+  // Names of one kind, from the model's name index
+  auto modelNames = [this](UMLNameKind kind) -> UMLNameCompleter::Source
+  {
+    return [this, kind](const vector<string>& previous, const string& prefix)
+    {
+      return Model.getNameIndex().complete(kind, prefix);
+    };
+  };
+  UMLNameCompleter::Source classNames = modelNames(UMLNameKind::className);
+  UMLNameCompleter::Source fieldNames = modelNames(UMLNameKind::field);
+  UMLNameCompleter::Source methodNames = modelNames(UMLNameKind::method);
+
+  // Types already in use, along with classes since they can be types too
+  UMLNameCompleter::Source typeNames = [this](const vector<string>& previous, const string& prefix)
+  {
+    vector<string> types = Model.getNameIndex().complete(UMLNameKind::type, prefix);
+    vector<string> classes = Model.getNameIndex().complete(UMLNameKind::className, prefix);
+    vector<string> result;
+    std::set_union(types.begin(), types.end(), classes.begin(), classes.end(), std::back_inserter(result));
+    if (result.size() > UMLNameIndex::DEFAULT_LIMIT)
+      result.resize(UMLNameIndex::DEFAULT_LIMIT);
+    return result;
+  };
+
+  UMLNameCompleter::Source relationshipTypes = [matching](const vector<string>& previous, const string& prefix)
+  {
+    return matching({"aggregation", "composition", "generalization", "realization"}, prefix);
+  };
+
+  // Saves in the working directory, as load and save take them
+  UMLNameCompleter::Source saveNames = [matching](const vector<string>& previous, const string& prefix)
+  {
+    return matching(UMLSaveCatalog::working().listSaves().get<vector<string>>(), prefix);
+  };
+
+  // Parameters of the selected method
+  UMLNameCompleter::Source paramNames = [this, matching](const vector<string>& previous, const string& prefix)
+  {
+    vector<string> names;
+    if (MethodSelected)
+      for (const UMLParameter& param : SelectedMethod->getParam())
+        names.push_back(param.getName());
+    return matching(names, prefix);
+  };
+
+  // Arguments that take new names aren't completed
+  UMLNameCompleter::Source newName = nullptr;
+
+  auto rootCompleter = make_unique<UMLNameCompleter>();
+  rootCompleter -> add("load", {saveNames});
+  rootCompleter -> add("save", {saveNames});
+  rootMenu -> Insert(std::move(rootCompleter));
+
+  auto classCompleter = make_unique<UMLNameCompleter>();
+  classCompleter -> add("view", {classNames});
+  classCompleter -> add("delete", {classNames});
+  classCompleter -> add("rename", {classNames, newName});
+  classMenu -> Insert(std::move(classCompleter));
+
+  auto relationshipCompleter = make_unique<UMLNameCompleter>();
+  relationshipCompleter -> add("add", {classNames, classNames, relationshipTypes});
+  relationshipCompleter -> add("delete", {classNames, classNames});
+  relationshipCompleter -> add("change", {classNames, classNames, relationshipTypes});
+  relationshipMenu -> Insert(std::move(relationshipCompleter));
+
+  auto fieldCompleter = make_unique<UMLNameCompleter>();
+  fieldCompleter -> add("add", {classNames, typeNames, newName});
+  fieldCompleter -> add("delete", {classNames, fieldNames});
+  fieldCompleter -> add("rename", {classNames, fieldNames, newName});
+  fieldCompleter -> add("change", {classNames, fieldNames, typeNames});
+  fieldMenu -> Insert(std::move(fieldCompleter));
+
+  auto methodCompleter = make_unique<UMLNameCompleter>();
+  methodCompleter -> add("select", {classNames, methodNames});
+  methodCompleter -> add("view_method", {classNames, methodNames});
+  methodCompleter -> add("add", {classNames, typeNames, newName});
+  methodCompleter -> add("change", {typeNames});
+  methodMenu -> Insert(std::move(methodCompleter));
+
+  auto parameterCompleter = make_unique<UMLNameCompleter>();
+  parameterCompleter -> add("add", {typeNames, newName});
+  parameterCompleter -> add("delete", {paramNames});
+  parameterCompleter -> add("rename", {paramNames, newName});
+  parameterCompleter -> add("change", {paramNames, typeNames});
+  parameterMenu -> Insert(std::move(parameterCompleter));
+
   //--------------------------------------------------------------------
 
   /*
@@ -547,12 +706,116 @@ void UMLCLI::start()
 }
 
 /**
- * @brief Lists all classes the user has created.
+ * @brief Runs commands from a stream without a terminal, for scripts
+ * and build pipelines. Nothing is prompted or echoed, and blank lines
+ * and lines starting with # are skipped. Each command is written as a
+ * line of json, with a summary line at the end:
+ * 
+ * {"command":"class add Box","line":3,"ok":true,"output":"..."}
+ * {"summary":{"commands":1,"failed":0,"seconds":0.0001}}
+ * 
+ * Results are written in large blocks rather than per line. History
+ * snapshots are only taken when an undo or redo needs one, so undo in
+ * a script undoes every edit since the previous undo or redo.
+ * 
+ * @param in
+ * @param out
+ * @return int
+ */
+int UMLCLI::run_script(std::istream& in, std::ostream& out)
+{
+  Cli cli = cli_menu();
+  SetNoColor();
+  BatchHistory = true;
+
+  // Commands print to cout as well as to the session, both are captured
+  std::ostringstream captured;
+  std::streambuf* previous = cout.rdbuf(captured.rdbuf());
+  CliSession session(cli, captured);
+  bool exited = false;
+  session.ExitAction([&exited](std::ostream& out) { exited = true; });
+  cli.StdExceptionHandler(
+    [this](std::ostream& out, const std::string& cmd, const std::exception& error)
+    {
+      CommandFailed = true;
+      out << error.what() << "\n";
+    });
+
+  string results;
+  string line;
+  size_t lineNumber = 0;
+  size_t commands = 0;
+  int failures = 0;
+  auto start = std::chrono::steady_clock::now();
+  try
+  {
+    while (!exited && std::getline(in, line))
+    {
+      ++lineNumber;
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      size_t first = line.find_first_not_of(" \t");
+      if (first == string::npos || line[first] == '#')
+        continue;
+
+      captured.str("");
+      CommandFailed = false;
+      session.Feed(line);
+      string output = captured.str();
+      // The cli library reports unknown commands only in its output
+      bool ok = !CommandFailed && output.rfind("wrong command", 0) != 0;
+      ++commands;
+      if (!ok)
+        ++failures;
+
+      results += json {{"line", lineNumber}, {"command", line}, {"ok", ok}, {"output", output}}.dump();
+      results += '\n';
+      if (results.size() >= SCRIPT_BUFFER_SIZE)
+      {
+        out << results;
+        results.clear();
+      }
+    }
+  }
+  catch (...)
+  {
+    cout.rdbuf(previous);
+    throw;
+  }
+  cout.rdbuf(previous);
+  flush_history();
+  BatchHistory = false;
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  results += json {{"summary", {{"commands", commands}, {"failed", failures}, {"seconds", seconds}}}}.dump();
+  results += '\n';
+  out << results;
+  out.flush();
+  return failures;
+}
+
+/************************************/
+
+/**
+ * @brief Lists the classes the user has created that pass the options'
+ * filters, a page at a time if asked. Classes are rendered as they're
+ * reached, and written out whenever the buffer fills.
  * 
+ * @param options 
  */
-void UMLCLI::list_classes()
+void UMLCLI::list_classes(const vector<string>& options)
 {
-  list<UMLClass> classList = Model.getClasses();
+  std::unique_ptr<UMLListFilter> filter;
+  if (!parse_list_filter(options, UMLListSubject::classes, filter))
+    return;
+
+  if (filter->counting())
+  {
+    cout << filter->countClasses(Model) << "\n";
+    return;
+  }
+
+  const list<UMLClass>& classList = Model.getClasses();
 
   //if no classes, error message.
   if (classList.size() == 0)
@@ -561,45 +824,161 @@ void UMLCLI::list_classes()
     return;
   }
   
-  for(auto currentClass : classList)   
-    display_class(currentClass);
-  
+  size_t matched = 0;
+  for(const auto& currentClass : classList)
+  {
+    if (!filter->matches(currentClass))
+      continue;
+    if (matched >= filter->pageStart())
+      Renderer.renderClass(currentClass);
+    // Without filters the total is known, so stop at the end of the page
+    if (++matched == filter->pageEnd() && filter->unfiltered())
+      break;
+    if (Renderer.str().size() >= LIST_FLUSH_SIZE)
+      Renderer.flush(cout);
+  }
+  if (filter->unfiltered())
+    matched = classList.size();
+
+  list_footer(*filter, matched, "classes");
+  Renderer.flush(cout);
 }
 
 /************************************/
 
 /**
- * @brief Lists all relationships the user has created.
+ * @brief Lists the relationships the user has created that pass the
+ * options' filters, a page at a time if asked.
  * 
+ * @param options 
  */
-void UMLCLI::list_relationships()
+void UMLCLI::list_relationships(const vector<string>& options)
 {
-  std::vector <UMLRelationship> allRelationships = Model.getRelationships();
+  std::unique_ptr<UMLListFilter> filter;
+  if (!parse_list_filter(options, UMLListSubject::relationships, filter))
+    return;
+
+  if (filter->counting())
+  {
+    cout << filter->countRelationships(Model) << "\n";
+    return;
+  }
+
+  const std::vector <UMLRelationship>& allRelationships = Model.getRelationships();
   if (allRelationships.size() == 0)
   {
     cout << "You have no relationships.\n";
     return;
   }
 
-  for(auto iter = allRelationships.begin(); iter != allRelationships.end(); iter++)
+  size_t matched = 0;
+  for(const UMLRelationship& relationship : allRelationships)
   {
-    if(iter != allRelationships.begin())
-      cout << "------------------------------------------------------\n\n"; 
+    if (!filter->matches(relationship))
+      continue;
+    if (matched >= filter->pageStart())
+    {
+      if (matched > filter->pageStart())
+        Renderer.append("------------------------------------------------------\n\n"); 
+      string rType = UMLRelationship::type_to_string(relationship.getType());
+      Renderer.renderRelationship(relationship.getSource(), relationship.getDestination(), rType);
+    }
+    if (++matched == filter->pageEnd() && filter->unfiltered())
+      break;
+    if (Renderer.str().size() >= LIST_FLUSH_SIZE)
+      Renderer.flush(cout);
+  }
+  if (filter->unfiltered())
+    matched = allRelationships.size();
 
-    UMLRelationship currentRel = *iter;
-    
-    UMLClass source = currentRel.getSource();
-    UMLClass destination = currentRel.getDestination();
-    
-    
-    string rType = Model.getRelationshipType(source.getName(), destination.getName());
+  list_footer(*filter, matched, "relationships");
+  Renderer.flush(cout);
+}
+
+/************************************/
 
-    display_relationship(source, destination, rType);
+/**
+ * @brief Shows the size of the diagram and an estimate of the memory it
+ * and its undo history take up, by part. Both are kept up to date as the
+ * diagram changes, so this is quick however big it is.
+ */
+void UMLCLI::show_stats()
+{
+  UMLFootprint footprint = Model.getFootprint();
+  std::ostringstream out;
+  out << footprint.getClassCount() << " classes, " << footprint.getFieldCount() << " fields, "
+    << footprint.getMethodCount() << " methods, " << footprint.getParameterCount() << " parameters, "
+    << footprint.getRelationshipCount() << " relationships\n\n";
+
+  const std::pair<string, size_t> parts[] = {
+    {"Strings", footprint.getStringBytes()},
+    {"Classes", footprint.getClassBytes()},
+    {"Attributes", footprint.getAttributeBytes()},
+    {"Parameters", footprint.getParameterBytes()},
+    {"Relationships", footprint.getRelationshipBytes()},
+    {"Indexes", footprint.getIndexBytes()},
+    {"Allocator overhead", footprint.getOverheadBytes()},
+    {"Total", footprint.getTotalBytes()}
+  };
+  out << "Estimated memory:\n";
+  for (const auto& part : parts)
+    out << "  " << std::left << std::setw(20) << part.first << std::right << std::setw(12) << part.second << " bytes\n";
+
+  out << "\nUndo history: " << History.undo_size() << " undo and " << History.redo_size()
+    << " redo snapshots, " << History.snapshot_bytes() << " bytes\n";
+  cout << out.str();
+}
+
+/************************************/
+
+/**
+ * @brief Parses listing options into a filter, printing the problem and
+ * returning false if they aren't valid.
+ * 
+ * @param options 
+ * @param subject 
+ * @param filter 
+ * @return true 
+ * @return false 
+ */
+bool UMLCLI::parse_list_filter(const vector<string>& options, UMLListSubject subject, std::unique_ptr<UMLListFilter>& filter)
+{
+  try
+  {
+    filter = std::make_unique<UMLListFilter>(options, subject);
+    return true;
+  }
+  catch (const std::runtime_error& error)
+  {
+    cout << error.what() << "\n";
+    CommandFailed = true;
+    return false;
   }
 }
 
 /************************************/
 
+/**
+ * @brief Adds the line below a listing that says which page was shown,
+ * or that nothing matched the filters.
+ * 
+ * @param filter 
+ * @param matched 
+ * @param things 
+ */
+void UMLCLI::list_footer(const UMLListFilter& filter, size_t matched, const string& things)
+{
+  if (matched == 0)
+    Renderer.append("No " + things + " match.\n");
+  else if (filter.paged() && filter.pageStart() >= matched)
+    Renderer.append("That page is past the end, there are " + std::to_string(matched) + " " + things + ".\n");
+  else if (filter.paged())
+    Renderer.append("Showing " + std::to_string(filter.pageStart() + 1) + "-"
+      + std::to_string(std::min(filter.pageEnd(), matched)) + " of " + std::to_string(matched) + " " + things + ".\n");
+}
+
+/************************************/
+
 /**
  * @brief User creates and names a class and may give it any number
  * of attributes.
@@ -610,6 +989,7 @@ void UMLCLI::create_class(string className)
 {
   if(Model.doesClassExist(className))
   {
+    CommandFailed = true;
     cout << "That class name already exists. Aborting.\n";
     return;
   }
@@ -645,16 +1025,19 @@ void UMLCLI::create_relationship(string source, string destination, string relsh
   
   // Check to see if source exists
   if(!Model.doesClassExist(source)) {
+    CommandFailed = true;
     cout << "The class \"" << source << "\" does not exist.\n";
     return;
   }
   // Check to see if destination exists
   else if(!Model.doesClassExist(destination)) {
+    CommandFailed = true;
     cout << "The class \"" << destination << "\" does not exist.\n";
     return;
   }
   // Check to see if relationship already exists
   else if(Model.doesRelationshipExist(source, destination)) {
+    CommandFailed = true;
     cout << "A relationship already exists between " << source << " and " << destination << ". Aborting.\n";
     return;
   }
@@ -673,6 +1056,7 @@ void UMLCLI::create_relationship(string source, string destination, string relsh
     typeIndex = 3;
   }
   else {
+    CommandFailed = true;
     cout << "Invalid type!\n";
     return;
   }
@@ -746,6 +1130,7 @@ void UMLCLI::rename_class(string oldClassName, string newClassName)
 {
   if (!Model.doesClassExist(oldClassName))
   {
+    CommandFailed = true;
     cout << "Error! The class you typed does not exist.\n";
     return;
   }
@@ -777,16 +1162,19 @@ void UMLCLI::change_relationship(string source, string destination, string relsh
   
   // Check to see if source exists
   if(!Model.doesClassExist(source)) {
+    CommandFailed = true;
     cout << "The class \"" << source << "\" does not exist.\n";
     return;
   }
   // Check to see if destination exists
   else if(!Model.doesClassExist(destination)) {
+    CommandFailed = true;
     cout << "The class \"" << destination << "\" does not exist.\n";
     return;
   }
   // Check to see if relationship already exists
   else if(Model.doesRelationshipExist(source, destination)) {
+    CommandFailed = true;
     cout << "A relationship already exists between " << source << " and " << destination << ". Aborting.\n";
     return;
   }
@@ -805,6 +1193,7 @@ void UMLCLI::change_relationship(string source, string destination, string relsh
     typeIndex = 3;
   }
   else {
+    CommandFailed = true;
     cout << "Invalid type!\n";
     return;
   }
@@ -851,6 +1240,7 @@ void UMLCLI::load_uml(string fileName)
   {
     cout << "\nError loading file\n\n";
     ErrorStatus = true;
+    CommandFailed = true;
   }
   if (!ErrorStatus) 
     cout << "Your file has been loaded\n";
@@ -1044,6 +1434,7 @@ void UMLCLI::rename_field(string className, string fieldNameFrom, string fieldNa
   }
   else if (Model.doesFieldExist(className, fieldNameTo))
   {
+    CommandFailed = true;
     cout << "Error! That field already exists. Aborting...\n";
     return;
   }
@@ -1195,112 +1586,10 @@ void UMLCLI::change_parameter(string paramName, string newParamType)
  * 
  * @param currentClass 
  */
-void UMLCLI::display_class(UMLClass currentClass)
+void UMLCLI::display_class(const UMLClass& currentClass)
 { 
-  string className = currentClass.getName();
-  size_t maxSize = className.size() + 2;
-  vector<attr_ptr> attributes = currentClass.getAttributes();
-  vector<string> fieldStrings;
-  vector<string> methodStrings;
-  
-  // STEP 1: Store the data of each attribute in a string with the correct format.
-  for(auto attIter : attributes)
-  {
-    if(attIter->identifier() == "field")
-    {
-      string fieldData = " " + attIter->getAttributeName() + " : " + attIter->getType() + " ";
-      fieldStrings.push_back(fieldData);
-    }
-
-    else
-    {
-      method_ptr methodIter = std::dynamic_pointer_cast<UMLMethod>(attIter);
-      
-      string methodData = " " + methodIter->getAttributeName() + "(";
-      list<UMLParameter> paramList = methodIter->getParam();
-      
-      int i = 0;
-      for(auto param : paramList)
-      {
-        if(i > 0)
-          methodData.append(", ");
-          
-        methodData.append(param.getName() + " : " + param.getType());
-        i++;
-      }
-
-      methodData.append(") : ");  
-      methodData.append(methodIter->getType());
-      methodData.append(" [");
-      methodData.append(std::to_string(method_number(className, methodIter)));
-      methodData.append("] ");
-      methodStrings.push_back(methodData);
-    }
-  }
-
-  // STEP 2: Check all internal strings and update maxSize if necessary.
-  for(auto i : fieldStrings)
-  {
-    if(maxSize < i.size())
-      maxSize = i.size();
-  }
-
-  for(auto i : methodStrings)
-  {
-    if(maxSize < i.size())
-      maxSize = i.size();
-  }
-
-  //STEP 3: Create each slice of the class box and store them in a vector.
-  
-  string edge = "+";
-  for(size_t i = 0; i < maxSize; i++)
-  {
-    edge.append("-");
-  }
-  edge.append("+");
-
-  cout << edge << "\n";
-
-  string classNameSlice = "| " + className;
-  for(size_t i = className.size() + 2; i < maxSize; i++)
-  {
-    classNameSlice.append(" ");
-  }
-  classNameSlice.append(" |");
-
-  cout << classNameSlice << "\n";
-  cout << edge << "\n";
-
-  for(auto fieldData : fieldStrings)
-  {
-    string slice = "|" + fieldData;
-    for(size_t i = fieldData.size(); i < maxSize; i++)
-    {
-      slice.append(" ");
-    }
-    slice.append("|");
-    cout << slice << "\n";
-  }
-  
-  if(fieldStrings.size() != 0)
-    cout << edge << "\n";
-
-  for(auto methodData : methodStrings)
-  {
-    string slice = "|" + methodData;
-    for(size_t i = methodData.size(); i < maxSize; i++)
-    {
-      slice.append(" ");
-    }
-    slice.append("|");
-    cout << slice << "\n";
-  }
-
-  if(methodStrings.size() != 0)
-    cout << edge << "\n";
-  
-  cout << "\n";
+  Renderer.renderClass(currentClass);
+  Renderer.flush(cout);
 }
 
 
@@ -1317,28 +1606,10 @@ void UMLCLI::display_class(UMLClass currentClass)
  * @param className
  * @param methodIter 
  */
-void UMLCLI::display_method(string className, method_ptr methodIter)
+void UMLCLI::display_method(const string& className, method_ptr methodIter)
 {     
-  string methodData = methodIter->getAttributeName() + "(";
-  list<UMLParameter> paramList = methodIter->getParam();
-  
-  int i = 0;
-  for(auto param : paramList)
-  {
-    if(i > 0)
-      methodData.append(", ");
-      
-    methodData.append(param.getName() + " : " + param.getType());
-    i++;
-  }
-
-  methodData.append(")"); 
-  methodData.append(" : "); 
-  methodData.append(methodIter->getType());
-  methodData.append(" [");
-  methodData.append(std::to_string(method_number(className, methodIter)));
-  methodData.append("] ");
-  cout << methodData << "\n";
+  Renderer.renderMethod(*methodIter, method_number(className, methodIter));
+  Renderer.flush(cout);
 }
 
 /*************************/
@@ -1380,13 +1651,10 @@ void UMLCLI::display_method(string className, method_ptr methodIter)
  * @param destination 
  * @param rType 
  */
-void UMLCLI::display_relationship(UMLClass source, UMLClass destination, string rType)
+void UMLCLI::display_relationship(const UMLClass& source, const UMLClass& destination, const string& rType)
 {
-  cout << "TYPE: " << rType << "\n\n";
-  cout << "SOURCE:\n";
-  display_class(source);
-  cout << "DESTINATION:\n";
-  display_class(destination);
+  Renderer.renderRelationship(source, destination, rType);
+  Renderer.flush(cout);
 }
 
 /**************************************************************/
@@ -1397,6 +1665,7 @@ void UMLCLI::display_relationship(UMLClass source, UMLClass destination, string
  */
 void UMLCLI::undo()
 {
+  flush_history();
   Model = History.undo();
   cout << "You\'ve undone your last action.\n";
 }
@@ -1408,10 +1677,38 @@ void UMLCLI::undo()
  */
 void UMLCLI::redo()
 {
+  flush_history();
   Model = History.redo();
   cout << "You\'ve redone your last undo.\n";
 }
 
+/*************************/
+
+/**
+ * @brief Snapshots the model after an edit. Scripts batch their edits,
+ * so this only marks that a snapshot is owed.
+ */
+void UMLCLI::save_history()
+{
+  if (BatchHistory)
+    HistoryPending = true;
+  else
+    History.save(Model);
+}
+
+/*************************/
+
+/**
+ * @brief Takes the snapshot a batch of edits is waiting on, if any.
+ */
+void UMLCLI::flush_history()
+{
+  if (!HistoryPending)
+    return;
+  History.save(Model);
+  HistoryPending = false;
+}
+
 /**************************************************************/
 //MISC.
 
@@ -1442,52 +1739,28 @@ attr_ptr UMLCLI::select_field(string className, string fieldName)
 /*************************/
 
 /**
- * @brief Searches the entire vector of attributes by name.
- * 
- * If there is a match, store the reference in a new vector. If that
- * match also shares the same parameters, it should return the vector index
- * that the new method was stored into.
+ * @brief Looks up a method's overload number in its class's overload
+ * table.
  * 
  * @param className 
- * @param methodName 
+ * @param method 
  * @return int
  */
-int UMLCLI::method_number(string className, method_ptr method) 
+int UMLCLI::method_number(const string& className, method_ptr method) 
 {
-  vector<method_ptr> methodMatches;
-  vector<attr_ptr> allAttributes = Model.getClassAttributes(className);
-
-  // Search the entire attribute vector and put matches in methodMatches
-  for(auto attributeIter : allAttributes)
-  {
-    // Check if there was a match
-    if(attributeIter->identifier() == "method" && attributeIter->getAttributeName() == method->getAttributeName())
-    {
-      method_ptr element = std::dynamic_pointer_cast<UMLMethod>(attributeIter);
-      // If these share the same parameters, return the appropriate overload integer.
-      
-      if (element->getParam() == method->getParam()) {
-        // Should be displaced by 1 postion of where it would be in the vector
-        return ((int) methodMatches.size()) + 1;
-      }
-      // If no match, continue creation of array
-      methodMatches.push_back(element);
-    }
-  }
+  int number = Model.getClass(className).getOverloadNumber(*method);
 
-  // If made past loop, the method cannot exist within the data.
-  throw std::runtime_error("Couldn\'t find method.");
-  return -1;
+  // If not in the table, the method cannot exist within the data.
+  if (number == 0)
+    throw std::runtime_error("Couldn\'t find method.");
+  return number;
 }
 
 /*************************/
 
 /**
- * @brief Searches the entire vector of attributes by name.
- * 
- * If there is a match, store the reference in a new vector. If that
- * match also shares the same parameters, it should return the vector index
- * that the new method was stored into.
+ * @brief Finds the method with the given name and overload number in
+ * its class's overload table.
  * 
  * @param className 
  * @param methodName 
@@ -1496,26 +1769,12 @@ int UMLCLI::method_number(string className, method_ptr method)
  */
  method_ptr UMLCLI::select_overload(string className, string methodName, int methodNumber) 
  {
-  vector<method_ptr> methodMatches;
-  vector<attr_ptr> allAttributes = Model.getClassAttributes(className);
+  attr_ptr method = Model.getClass(className).getOverload(methodName, methodNumber);
 
-  //Search the entire attribute vector and put matches in methodMatches
-  for(auto attributeIter : allAttributes)
-  {
-    if(attributeIter->identifier() == "method" && attributeIter->getAttributeName() == methodName)
-    {
-      method_ptr element = std::dynamic_pointer_cast<UMLMethod>(attributeIter);
-      methodMatches.push_back(element);
-      // Should have reached element when the number matches the size
-      if(methodNumber == (int) methodMatches.size()) {
-        return element;
-      }
-    }
-  }
-
-  // If made past loop, the method cannot exist within the data.
-  throw std::runtime_error("Couldn\'t find method.");
-  return nullptr;
+  // If not in the table, the method cannot exist within the data.
+  if (!method)
+    throw std::runtime_error("Couldn\'t find method.");
+  return std::static_pointer_cast<UMLMethod>(method);
  }
 
 /*************************/
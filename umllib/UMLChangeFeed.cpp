@@ -0,0 +1,60 @@
+/*
+  Filename   : UMLChangeFeed.cpp
+  Description: Implementation of the model change feed.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLChangeFeed.hpp"
+//--------------------------------------------------------------------
+
+// Constructor: takes in how many events are kept for resuming clients
+UMLChangeFeed::UMLChangeFeed(size_t newCapacity)
+:capacity(newCapacity)
+{
+}
+
+// Adds an event and wakes every waiting reader
+void UMLChangeFeed::publish(unsigned long version, string payload)
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    events.push_back(Event{version, std::move(payload)});
+    if (events.size() > capacity)
+      events.pop_front();
+    latestVersion = version;
+  }
+  published.notify_all();
+}
+
+// Collects events newer than version into out, waiting up to timeout for
+// one to arrive. Returns false if events after version were already
+// dropped, meaning the caller has to reload the whole model.
+bool UMLChangeFeed::waitSince(unsigned long version, std::chrono::milliseconds timeout, std::vector<Event>& out)
+{
+  std::unique_lock<std::mutex> guard(lock);
+  // A version from the future means the server restarted under the client
+  if (version > latestVersion)
+    return false;
+  published.wait_for(guard, timeout, [&] { return latestVersion > version; });
+
+  if (latestVersion == version)
+    return true;
+  // The event right after version has to still be around
+  if (events.empty() || events.front().version > version + 1)
+    return false;
+
+  for (const Event& event : events)
+  {
+    if (event.version > version)
+      out.push_back(event);
+  }
+  return true;
+}
+
+// Returns the version of the newest event published
+unsigned long UMLChangeFeed::latest()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return latestVersion;
+}
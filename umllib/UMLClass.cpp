@@ -9,6 +9,9 @@
 #include "include/UMLAttribute.hpp"
 #include "include/UMLField.hpp"
 #include "include/UMLMethod.hpp"
+#include "include/UMLTrace.hpp"
+
+#include <algorithm>
 //--------------------------------------------------------------------
 
 //--------------------------------------------------------------------
@@ -23,7 +26,7 @@ UMLClass::UMLClass(string newClass)
 }
 
 // Grab name from given class object
-string UMLClass::getName() const
+const string& UMLClass::getName() const
 {
 	return className;
 }
@@ -49,22 +52,39 @@ void UMLClass::addAttribute(const UMLAttribute& newAttribute)
 	}
 }
 
-// Adds attribute to attribute vector with a smart pointer
+// Adds attribute to attribute vector with a smart pointer. The attribute keeps
+// an id it already has, such as when a class is copied, otherwise gets a new one.
 void UMLClass::addAttribute(std::shared_ptr<UMLAttribute> newAttribute) 
 {
+	unsigned long id = newAttribute->getId();
+	if (id == 0 || attributeSlots.count(id))
+	{
+		id = nextAttributeId;
+		newAttribute->setId(id);
+	}
+	nextAttributeId = std::max(nextAttributeId, id + 1);
+	attributeSlots[id] = classAttributes.size();
 	classAttributes.push_back(newAttribute); // NEW POINTER VECTOR
+	if (newAttribute->identifier() == "method")
+		addOverload(*newAttribute);
 }
 
 // Changes name of attribute within class
 void UMLClass::changeAttributeName(string oldAttributeName, string newAttributeName)
 {
-	getAttribute(oldAttributeName)->changeName(newAttributeName);
+	changeAttributeName(getAttribute(oldAttributeName), newAttributeName);
 }
 
 // Changes name of attribute within class using smart ptr 
 void UMLClass::changeAttributeName(std::shared_ptr<UMLAttribute> attribute, string newAttributeName) 
 {
+	// Renamed methods move over to the overloads of their new name
+	bool tracked = attribute->identifier() == "method" && overloadNumbers.count(attribute->getId());
+	if (tracked)
+		removeOverload(*attribute);
 	attribute->changeName(newAttributeName);
+	if (tracked)
+		addOverload(*attribute);
 }
 
 // Remove attributes from pointer vector
@@ -76,8 +96,11 @@ void UMLClass::deleteAttribute(string attributeName)
 		throw std::runtime_error("Attribute not found");
 	}
 
+	if (classAttributes[loc]->identifier() == "method")
+		removeOverload(*classAttributes[loc]);
+	attributeSlots.erase(classAttributes[loc]->getId());
 	classAttributes.erase(classAttributes.begin() + loc);
-
+	updateSlots(loc);
 }
 
 // Remove attribute from pointer vector by pointer
@@ -87,7 +110,11 @@ void UMLClass::deleteAttribute(std::shared_ptr<UMLAttribute> attributePtr)
 	{
 		if(attributePtr == classAttributes[i])
 		{
+			if (attributePtr->identifier() == "method")
+				removeOverload(*attributePtr);
+			attributeSlots.erase(attributePtr->getId());
 			classAttributes.erase(classAttributes.begin() + i);
+			updateSlots(i);
 			return;
 		}
 	}
@@ -111,6 +138,7 @@ int UMLClass::findAttribute(string attributeName)
 // If true, it causes identical attributes. If false, it does not
 bool UMLClass::checkAttribute(std::shared_ptr<UMLAttribute> attribute)
 {
+	UML_TRACE_SCOPE("UMLClass::checkAttribute");
 	if(attribute->identifier() == "field") {
 		for (int i = 0; i < classAttributes.size(); ++i) {
 			// Check if the name is the same--doesn't matter if it's a field or method
@@ -129,8 +157,8 @@ bool UMLClass::checkAttribute(std::shared_ptr<UMLAttribute> attribute)
 			}
 			// If they share the same name but they are both methods, check parameters
 			else if (classAttributes[i]->getAttributeName() == attribute->getAttributeName() && classAttributes[i]->identifier() == "method"){
-				list<UMLParameter> params1 = std::dynamic_pointer_cast<UMLMethod>(classAttributes[i])->getParam();
-				list<UMLParameter> params2 = std::dynamic_pointer_cast<UMLMethod>(attribute)->getParam();
+				const list<UMLParameter>& params1 = std::static_pointer_cast<UMLMethod>(classAttributes[i])->getParam();
+				const list<UMLParameter>& params2 = std::static_pointer_cast<UMLMethod>(attribute)->getParam();
 				// Parameters are equal, so this breaks overload rules
 				if (params1 == params2) {
 					return true;
@@ -157,8 +185,97 @@ std::shared_ptr<UMLAttribute> UMLClass::getAttribute(string attributeName)
 	return classAttributes[loc];
 }
 
+// Finds attribute by its id, throws if the class has no such attribute
+std::shared_ptr<UMLAttribute> UMLClass::getAttributeById(unsigned long id) const
+{
+	auto slot = attributeSlots.find(id);
+	if (slot == attributeSlots.end())
+	{
+		throw std::runtime_error("Attribute not found");
+	}
+	return classAttributes[slot->second];
+}
+
+// Updates the slots of attributes at or after the given position, after
+// one before them was removed
+void UMLClass::updateSlots(size_t from)
+{
+	for (size_t i = from; i < classAttributes.size(); ++i)
+	{
+		attributeSlots[classAttributes[i]->getId()] = i;
+	}
+}
+
+// Overload number of a method among the methods sharing its name,
+// counting from 1. Returns 0 if the class has no such method.
+int UMLClass::getOverloadNumber(const UMLAttribute& method) const
+{
+	auto number = overloadNumbers.find(method.getId());
+	if (number == overloadNumbers.end())
+	{
+		return 0;
+	}
+	// Ids are only unique within a class, so make sure it's the same method
+	auto ids = overloads.find(method.getAttributeName());
+	if (ids == overloads.end() || ids->second[number->second - 1] != method.getId())
+	{
+		return 0;
+	}
+	return number->second;
+}
+
+// Method with the given name and overload number, or nullptr
+std::shared_ptr<UMLAttribute> UMLClass::getOverload(const string& methodName, int number) const
+{
+	auto ids = overloads.find(methodName);
+	if (ids == overloads.end() || number < 1 || number > (int) ids->second.size())
+	{
+		return nullptr;
+	}
+	return classAttributes[attributeSlots.at(ids->second[number - 1])];
+}
+
+// Adds a method to the overloads of its name. Methods are usually added
+// at the end of the class, but renamed ones keep their place, so the
+// method goes in after the last overload that comes before it.
+void UMLClass::addOverload(const UMLAttribute& method)
+{
+	vector<unsigned long>& ids = overloads[method.getAttributeName()];
+	size_t slot = attributeSlots.at(method.getId());
+	auto position = std::upper_bound(ids.begin(), ids.end(), slot,
+		[this](size_t methodSlot, unsigned long id) { return methodSlot < attributeSlots.at(id); });
+	position = ids.insert(position, method.getId());
+	for (auto i = position; i != ids.end(); ++i)
+	{
+		overloadNumbers[*i] = (int) (i - ids.begin()) + 1;
+	}
+}
+
+// Removes a method from the overloads of its name, renumbering the
+// overloads after it
+void UMLClass::removeOverload(const UMLAttribute& method)
+{
+	auto number = overloadNumbers.find(method.getId());
+	if (number == overloadNumbers.end())
+	{
+		return;
+	}
+	vector<unsigned long>& ids = overloads[method.getAttributeName()];
+	size_t position = number->second - 1;
+	ids.erase(ids.begin() + position);
+	overloadNumbers.erase(number);
+	for (size_t i = position; i < ids.size(); ++i)
+	{
+		overloadNumbers[ids[i]] = (int) i + 1;
+	}
+	if (ids.empty())
+	{
+		overloads.erase(method.getAttributeName());
+	}
+}
+
 // Returns vector pointer of attributes 
-vector<std::shared_ptr<UMLAttribute>> UMLClass::getAttributes() const
+const vector<std::shared_ptr<UMLAttribute>>& UMLClass::getAttributes() const
 {
 	return classAttributes;
 }
@@ -176,13 +293,13 @@ void UMLClass::setY(int val)
 }
 
 //gets the x value
-int UMLClass::getX()
+int UMLClass::getX() const
 {
 	return x;
 }
 
 //gets the y value
-int UMLClass::getY()
+int UMLClass::getY() const
 {
 	return y;
 }
@@ -0,0 +1,110 @@
+/*
+  Filename   : UMLCompression.cpp
+  Description: Implementation of gzip compression for the server.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLCompression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include <zlib.h>
+//--------------------------------------------------------------------
+
+// Adding 16 to zlib's window bits selects the gzip wrapper
+static const int GZIP_WINDOW_BITS = 15 + 16;
+
+// Compresses data into the gzip format
+string UMLCompression::gzip(const string& data)
+{
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    throw std::runtime_error("Could not start compression");
+
+  // The bound is the most deflate can produce, so one call always finishes
+  string compressed(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = compressed.size();
+  int result = deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END)
+    throw std::runtime_error("Could not compress data");
+  return compressed;
+}
+
+// Decompresses gzip data, throws if it is not valid
+string UMLCompression::gunzip(const string& data)
+{
+  z_stream stream = {};
+  if (inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK)
+    throw std::runtime_error("Could not start decompression");
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  string decompressed;
+  char buffer[16384];
+  int result = Z_OK;
+  while (result == Z_OK)
+  {
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+    decompressed.append(buffer, sizeof(buffer) - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  if (result != Z_STREAM_END)
+    throw std::runtime_error("Could not decompress data");
+  return decompressed;
+}
+
+// Checks an Accept-Encoding header value for gzip. A gzip (or *) entry
+// counts unless the client turned it off with q=0.
+bool UMLCompression::acceptsGzip(const string& acceptEncoding)
+{
+  size_t start = 0;
+  while (start < acceptEncoding.size())
+  {
+    size_t end = acceptEncoding.find(',', start);
+    if (end == string::npos)
+      end = acceptEncoding.size();
+    string entry = acceptEncoding.substr(start, end - start);
+    entry.erase(std::remove_if(entry.begin(), entry.end(), ::isspace), entry.end());
+    std::transform(entry.begin(), entry.end(), entry.begin(), ::tolower);
+    start = end + 1;
+
+    size_t parameters = entry.find(';');
+    string coding = entry.substr(0, parameters);
+    if (coding != "gzip" && coding != "*")
+      continue;
+    if (parameters == string::npos)
+      return true;
+    size_t quality = entry.find("q=", parameters);
+    if (quality == string::npos)
+      return true;
+    try
+    {
+      return std::stod(entry.substr(quality + 2)) > 0;
+    }
+    catch (const std::exception& error)
+    {
+      // A malformed weight is ignored like the rest of the header
+    }
+  }
+  return false;
+}
+
+// Returns true for content types that are worth compressing. Images and
+// other binary types are already compressed.
+bool UMLCompression::isCompressible(const string& type)
+{
+  return type.compare(0, 5, "text/") == 0
+    || type == "application/json"
+    || type == "application/javascript"
+    || type == "image/svg+xml";
+}
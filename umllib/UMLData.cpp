@@ -14,9 +14,12 @@
 #include "include/UMLField.hpp"
 #include "include/UMLFile.hpp"
 #include "include/UMLMethod.hpp"
+#include "include/UMLMetrics.hpp"
 #include "include/UMLParameter.hpp"
 #include "include/UMLRelationship.hpp"
+#include "include/UMLTrace.hpp"
 #include <algorithm>
+#include <iterator>
 #include <list>
 #include <memory>
 
@@ -60,7 +63,7 @@ UMLData::UMLData(const vector<UMLClass>& vclass)
  * 
  * @return list<UMLClass> 
  */
-list<UMLClass> UMLData::getClasses() const
+const list<UMLClass>& UMLData::getClasses() const
 {
   return classes;
 }
@@ -74,7 +77,7 @@ list<UMLClass> UMLData::getClasses() const
  * 
  * @return vector<UMLRelationship> 
  */
-vector<UMLRelationship> UMLData::getRelationships() const
+const vector<UMLRelationship>& UMLData::getRelationships() const
 {
   return relationships;
 }
@@ -173,6 +176,57 @@ string UMLData::getRelationshipType(const string& srcName, const string& destNam
 /************************************/
 
 
+/**
+ * @brief Returns the index of names used in the model, for completing
+ * names from a prefix.
+ * 
+ * @return const UMLNameIndex& 
+ */
+const UMLNameIndex& UMLData::getNameIndex() const
+{
+  return names;
+}
+
+
+/************************************/
+
+
+/**
+ * @brief Returns the number of relationships of the given type, kept as
+ * relationships are added, changed and deleted.
+ * 
+ * @param type 
+ * @return size_t 
+ */
+size_t UMLData::countRelationships(Type type) const
+{
+  return relationshipTypeCounts[type];
+}
+
+
+/************************************/
+
+
+/**
+ * @brief Returns how much memory the model takes up and where it goes.
+ * Everything but the relationship vector and name index is counted as the
+ * model changes, and those two know their own sizes, so this never walks
+ * the model.
+ * 
+ * @return UMLFootprint 
+ */
+UMLFootprint UMLData::getFootprint() const
+{
+  UMLFootprint result = footprint;
+  result.setRelationships(relationships.size(), relationships.capacity());
+  result.setNameIndex(names.bytes(), names.allocations());
+  return result;
+}
+
+
+/************************************/
+
+
 /**
  * @brief Gets relationship reference for the given string class names.
  * 
@@ -193,12 +247,20 @@ UMLRelationship& UMLData::getRelationship(string srcName, string destName)
 
 
 /**
- * @brief Generates json file given a set of data.
+ * @brief Generates json file given a set of data. Attribute ids are left
+ * out of save files, but history snapshots keep them so undo and redo
+ * don't renumber attributes.
  * 
+ * @param withIds
  * @return json 
  */
-json UMLData::getJson()
+json UMLData::getJson(bool withIds) const
 {
+  UML_TRACE_SCOPE("UMLData::getJson");
+  static UMLHistogram& serializeTime = UMLMetrics::global().histogram("uml_model_serialize_seconds",
+    "Time taken by UMLData::getJson");
+  UMLTimer timer(serializeTime);
+
   json jsonObj;
   jsonObj["classes"] = json::array();
 
@@ -211,7 +273,12 @@ json UMLData::getJson()
     for (auto uattr : uclass.getAttributes())
     {
       if (uattr->identifier() == "field")
-        jsonattr["fields"] += { {"name", uattr->getAttributeName()}, {"type", uattr->getType()} };
+      {
+        json field = { {"name", uattr->getAttributeName()}, {"type", uattr->getType()} };
+        if (withIds)
+          field["id"] = uattr->getId();
+        jsonattr["fields"] += field;
+      }
 
       else
       {
@@ -221,7 +288,10 @@ json UMLData::getJson()
           jsonparams += {{"name", param.getName()}, {"type", param.getType()}};
         } 
 
-        jsonattr["methods"] += {{"name", uattr->getAttributeName()}, {"return_type", uattr->getType()}, {"params", jsonparams}};
+        json method = {{"name", uattr->getAttributeName()}, {"return_type", uattr->getType()}, {"params", jsonparams}};
+        if (withIds)
+          method["id"] = uattr->getId();
+        jsonattr["methods"] += method;
       }
     } 
     jsonObj["classes"] += { {"name", uclass.getName()}, {"position_x", uclass.getX()}, {"position_y", uclass.getY()}, {"fields", jsonattr["fields"]}, {"methods", jsonattr["methods"]} };
@@ -233,7 +303,7 @@ json UMLData::getJson()
     jsonObj["relationships"] += { 
       {"source", urelationship.getSource().getName()}, 
       {"destination", urelationship.getDestination().getName()},
-      {"type", getRelationshipType(urelationship.getSource().getName(), urelationship.getDestination().getName())}
+      {"type", UMLRelationship::type_to_string(urelationship.getType())}
     };
   }
   return jsonObj;
@@ -243,6 +313,46 @@ json UMLData::getJson()
 /************************************/
 
 
+/**
+ * @brief Returns a copy that shares nothing with this one. Copying UMLData
+ * directly shares attributes and leaves relationships pointing at the
+ * original's classes, so attributes are cloned (keeping their ids) and
+ * relationships are rebuilt against the copy's classes.
+ * 
+ * @return UMLData 
+ */
+UMLData UMLData::clone() const
+{
+  UML_TRACE_SCOPE("UMLData::clone");
+  UMLData copy;
+  map<string, const UMLClass*> copies;
+  for (const UMLClass& uclass : classes)
+  {
+    UMLClass classCopy(uclass.getName());
+    classCopy.setX(uclass.getX());
+    classCopy.setY(uclass.getY());
+    for (const attr_ptr& attr : uclass.getAttributes())
+      classCopy.addAttribute(attr->clone());
+    copy.classes.push_back(std::move(classCopy));
+    copies[uclass.getName()] = &copy.classes.back();
+  }
+  copy.names = names;
+  copy.footprint = footprint;
+  std::copy(std::begin(relationshipTypeCounts), std::end(relationshipTypeCounts), std::begin(copy.relationshipTypeCounts));
+  for (const UMLRelationship& relationship : relationships)
+  {
+    copy.relationships.push_back(UMLRelationship(
+      *copies[relationship.getSource().getName()],
+      *copies[relationship.getDestination().getName()],
+      relationship.getType()));
+  }
+  return copy;
+}
+
+
+/************************************/
+
+
 //-----------------------------------------------------------------------
 // Memento pattern - creates snapshots that are able to be restored
 
@@ -285,12 +395,20 @@ json UMLData::getJson()
  */
 void UMLData::addClassObject(const UMLClass& classIn)
 {
+  UML_TRACE_SCOPE("UMLData::addClassObject");
   //check if already exists
   if (doesClassExist(classIn.getName()))
     throw std::runtime_error("Class name already exists");
   if (!isValidName(classIn.getName()))
     throw std::runtime_error("Class name not valid");
   classes.push_back(classIn);
+  names.add(UMLNameKind::className, classIn.getName());
+  footprint.addClass(classIn);
+  for (const attr_ptr& attr : classIn.getAttributes())
+  {
+    indexAttribute(*attr);
+    footprint.addAttribute(*attr);
+  }
 }
 
 
@@ -305,6 +423,7 @@ void UMLData::addClassObject(const UMLClass& classIn)
  */
 void UMLData::addClass(string name)
 {
+  UML_TRACE_SCOPE("UMLData::addClass");
   addClassObject(UMLClass(name));
 }
 
@@ -322,6 +441,7 @@ void UMLData::addClass(string name)
  */
 void UMLData::addRelationship(string srcName, string destName, int type)
 {
+  UML_TRACE_SCOPE("UMLData::addRelationship");
   // Type must be in bounds
   if (type < 0 || type > 3) 
     throw std::runtime_error("Invalid type");
@@ -340,11 +460,14 @@ void UMLData::addRelationship(string srcName, string destName, int type)
  */
 void UMLData::addClassAttribute(string className, attr_ptr attribute)
 {
+  UML_TRACE_SCOPE("UMLData::addClassAttribute");
   if (!isValidName(attribute->getAttributeName()))
     throw std::runtime_error("Attribute name is not valid");
-  else if (!isValidName(attribute->getType()))
+  if (!isValidName(attribute->getType()))
     throw std::runtime_error("Attribute type is not valid");
-  else if (getClass(className).checkAttribute(attribute)) {
+  // Looked up once, batches add many attributes in a row
+  UMLClass& uclass = getClass(className);
+  if (uclass.checkAttribute(attribute)) {
     if (attribute->identifier() == "field") {
       throw std::runtime_error("Field cannot be added, conflicts with other attributes");
     }
@@ -352,7 +475,9 @@ void UMLData::addClassAttribute(string className, attr_ptr attribute)
       throw std::runtime_error("Method cannot be added, conflicts with other attributes");
     }
   }
-  getClass(className).addAttribute(attribute);
+  uclass.addAttribute(attribute);
+  indexAttribute(*attribute);
+  footprint.addAttribute(*attribute);
 }
 
 
@@ -368,6 +493,7 @@ void UMLData::addClassAttribute(string className, attr_ptr attribute)
  */
 void UMLData::addParameter(string className, method_ptr method, string paramName, string paramType)
 {
+  UML_TRACE_SCOPE("UMLData::addParameter");
   if (!isValidName(paramName))
     throw std::runtime_error("Parameter name is not valid");
 
@@ -403,6 +529,8 @@ void UMLData::addParameter(string className, method_ptr method, string paramName
   }
  
   method->addParam(UMLParameter(paramName, paramType));
+  names.add(UMLNameKind::type, paramType);
+  footprint.addParameter(method->getParam().back());
 }
 
 
@@ -417,6 +545,7 @@ void UMLData::addParameter(string className, method_ptr method, string paramName
  */
 void UMLData::deleteClass(string name)
 {
+  UML_TRACE_SCOPE("UMLData::deleteClass");
   if (!doesClassExist(name))
     throw std::runtime_error("Class not found");
   
@@ -429,7 +558,15 @@ void UMLData::deleteClass(string name)
   }
 
   //remove class
-  classes.erase(findClass(name));
+  list<UMLClass>::iterator removed = findClass(name);
+  for (const attr_ptr& attr : removed->getAttributes())
+  {
+    unindexAttribute(*attr);
+    footprint.removeAttribute(*attr);
+  }
+  names.remove(UMLNameKind::className, name);
+  footprint.removeClass(*removed);
+  classes.erase(removed);
 }
 
 
@@ -444,9 +581,11 @@ void UMLData::deleteClass(string name)
  */
 void UMLData::deleteRelationship(string srcName, string destName)
 {
+  UML_TRACE_SCOPE("UMLData::deleteRelationship");
   int location = findRelationship(getClass(srcName), getClass(destName));
   if (location < 0)
     throw std::runtime_error("Relationship not found");
+  --relationshipTypeCounts[relationships[location].getType()];
   relationships.erase(relationships.begin() + location);
 }
 
@@ -463,7 +602,10 @@ void UMLData::deleteRelationship(string srcName, string destName)
  */
 void UMLData::removeClassAttribute(string className, attr_ptr attr)
 {
+  UML_TRACE_SCOPE("UMLData::removeClassAttribute");
   getClass(className).deleteAttribute(attr); // Error handing in UMLClass
+  unindexAttribute(*attr);
+  footprint.removeAttribute(*attr);
 }
 
 
@@ -478,6 +620,7 @@ void UMLData::removeClassAttribute(string className, attr_ptr attr)
  */
 void UMLData::deleteParameter(string className, method_ptr method, string paramName) 
 {
+  UML_TRACE_SCOPE("UMLData::deleteParameter");
   method_ptr testAttribute = std::make_shared<UMLMethod>(method->getAttributeName(), method->getType(), 
     std::dynamic_pointer_cast<UMLMethod>(method)->getParam());
 
@@ -487,7 +630,15 @@ void UMLData::deleteParameter(string className, method_ptr method, string paramN
     throw std::runtime_error("This parameter cannot be deleted now, as it would cause duplicate methods to exist.");
   }
 
+  // Kept for the index, the parameter is gone once deleted
+  string paramType;
+  for (const UMLParameter& param : method->getParam())
+    if (param.getName() == paramName)
+      paramType = param.getType();
+
   method->deleteParameter(paramName);
+  names.remove(UMLNameKind::type, paramType);
+  footprint.removeParameter(UMLParameter(paramName, paramType));
 }
 
 
@@ -503,12 +654,15 @@ void UMLData::deleteParameter(string className, method_ptr method, string paramN
  */
 void UMLData::changeClassName(string oldName, string newName)
 {
+  UML_TRACE_SCOPE("UMLData::changeClassName");
   //change class name
   if (doesClassExist(newName))
     throw std::runtime_error("Class name already exists");
   if (!isValidName(newName))
     throw std::runtime_error("New class name is not valid");
   getClass(oldName).changeName(newName);
+  names.rename(UMLNameKind::className, oldName, newName);
+  footprint.rename(oldName, newName);
   //change name in relationship
 }
 
@@ -525,6 +679,7 @@ void UMLData::changeClassName(string oldName, string newName)
  */
 void UMLData::changeAttributeName(string className, attr_ptr attribute, string newAttributeName)
 {
+  UML_TRACE_SCOPE("UMLData::changeAttributeName");
   // Make attribute that has the same type but a different name
   attr_ptr newAttribute;
   
@@ -543,7 +698,11 @@ void UMLData::changeAttributeName(string className, attr_ptr attribute, string n
   }
   else if (!isValidName(newAttributeName))
     throw std::runtime_error("New attribute name is not valid");
+  string oldAttributeName = attribute->getAttributeName();
   getClass(className).changeAttributeName(attribute, newAttributeName);
+  names.rename(attribute->identifier() == "method" ? UMLNameKind::method : UMLNameKind::field,
+    oldAttributeName, newAttributeName);
+  footprint.rename(oldAttributeName, newAttributeName);
 }
 
 
@@ -560,11 +719,13 @@ void UMLData::changeAttributeName(string className, attr_ptr attribute, string n
  */
 void UMLData::changeParameterName(method_ptr methodIter, string oldParamName, string newParamName)
 {
+  UML_TRACE_SCOPE("UMLData::changeParameterName");
   if (!isValidName(newParamName))
     throw std::runtime_error("New parameter name is not valid");
   if (doesParameterExist(methodIter, newParamName))
     throw std::runtime_error("That name is already taken.");
   methodIter->changeParameterName(oldParamName, newParamName);
+  footprint.rename(oldParamName, newParamName);
 }
 
 
@@ -581,6 +742,7 @@ void UMLData::changeParameterName(method_ptr methodIter, string oldParamName, st
  */
 void UMLData::changeRelationshipType(const string& srcName, const string& destName, int newType) 
 {
+  UML_TRACE_SCOPE("UMLData::changeRelationshipType");
   // Also throws exception if nonexistent relationship.
   int oldType = getRelationship(srcName, destName).getType();
 
@@ -608,7 +770,10 @@ void UMLData::changeRelationshipType(const string& srcName, const string& destNa
       }
     }
   }
-  getRelationship(srcName, destName).setType(newType);
+  UMLRelationship& relationship = getRelationship(srcName, destName);
+  --relationshipTypeCounts[relationship.getType()];
+  relationship.setType(newType);
+  ++relationshipTypeCounts[relationship.getType()];
 }
 
 
@@ -623,9 +788,12 @@ void UMLData::changeRelationshipType(const string& srcName, const string& destNa
  */
 void UMLData::changeAttributeType(attr_ptr attribute, string newTypeName)
 {
+  UML_TRACE_SCOPE("UMLData::changeAttributeType");
   if (!isValidName(newTypeName))
     throw std::runtime_error("New type name is not valid");
   else {
+    names.rename(UMLNameKind::type, attribute->getType(), newTypeName);
+    footprint.rename(attribute->getType(), newTypeName);
     attribute->changeType(newTypeName);
   }
 }
@@ -645,6 +813,7 @@ void UMLData::changeAttributeType(attr_ptr attribute, string newTypeName)
  */
 void UMLData::changeParameterType(string className, method_ptr methodIter, string paramName, string newParamType)
 {
+  UML_TRACE_SCOPE("UMLData::changeParameterType");
   method_ptr testAttribute = std::make_shared<UMLMethod>(methodIter->getAttributeName(), methodIter->getType(), 
     std::dynamic_pointer_cast<UMLMethod>(methodIter)->getParam());
 
@@ -657,7 +826,14 @@ void UMLData::changeParameterType(string className, method_ptr methodIter, strin
   else if (!isValidName(newParamType))
     throw std::runtime_error("New parameter type name is not valid");
 
+  string oldParamType;
+  for (const UMLParameter& param : methodIter->getParam())
+    if (param.getName() == paramName)
+      oldParamType = param.getType();
+
   methodIter->changeParameterType(paramName, newParamType); 
+  names.rename(UMLNameKind::type, oldParamType, newParamType);
+  footprint.rename(oldParamType, newParamType);
 }
 
 /**************************************************************/
@@ -673,10 +849,8 @@ void UMLData::changeParameterType(string className, method_ptr methodIter, strin
  */
 bool UMLData::doesClassExist(const string& name)
 {
-  list<UMLClass>::iterator findIter = findClass(name);
-  if (findIter == classes.end())
-    return false;
-  return true;
+  // The name index holds every class name, so there's no need to search
+  return names.contains(UMLNameKind::className, name);
 }
 
 
@@ -925,6 +1099,7 @@ UMLClass& UMLData::getClass(string name)
  */
 void UMLData::addRelationship(const UMLRelationship& relIn)
 {
+  UML_TRACE_SCOPE("UMLData::addRelationship");
   // Check to see if relationship already exists
   int loc = findRelationship(relIn.getSource(), relIn.getDestination());
   if (loc >= 0)
@@ -946,4 +1121,45 @@ void UMLData::addRelationship(const UMLRelationship& relIn)
     }
   }
   relationships.push_back(relIn); 
-}
\ No newline at end of file
+  ++relationshipTypeCounts[relIn.getType()];
+}
+
+/************************************/
+
+/**
+ * @brief Adds the name and types an attribute uses to the name index.
+ * 
+ * @param attribute 
+ */
+void UMLData::indexAttribute(const UMLAttribute& attribute)
+{
+  if (attribute.identifier() == "method")
+  {
+    names.add(UMLNameKind::method, attribute.getAttributeName());
+    for (const UMLParameter& param : static_cast<const UMLMethod&>(attribute).getParam())
+      names.add(UMLNameKind::type, param.getType());
+  }
+  else
+    names.add(UMLNameKind::field, attribute.getAttributeName());
+  names.add(UMLNameKind::type, attribute.getType());
+}
+
+/************************************/
+
+/**
+ * @brief Drops the name and types an attribute uses from the name index.
+ * 
+ * @param attribute 
+ */
+void UMLData::unindexAttribute(const UMLAttribute& attribute)
+{
+  if (attribute.identifier() == "method")
+  {
+    names.remove(UMLNameKind::method, attribute.getAttributeName());
+    for (const UMLParameter& param : static_cast<const UMLMethod&>(attribute).getParam())
+      names.remove(UMLNameKind::type, param.getType());
+  }
+  else
+    names.remove(UMLNameKind::field, attribute.getAttributeName());
+  names.remove(UMLNameKind::type, attribute.getType());
+}
@@ -7,36 +7,56 @@
 // System includes
 #include "include/UMLDataHistory.hpp"
 #include "include/UMLFile.hpp"
+#include "include/UMLFootprint.hpp"
+#include "include/UMLMetrics.hpp"
+#include "include/UMLTrace.hpp"
+
+#include <algorithm>
 //--------------------------------------------------------------------
 
 // Constructor that adds the originator to the history
 UMLDataHistory::UMLDataHistory(UMLData& data)
 { 
-    current = data.getJson();
+    current = data.getJson(true);
+    currentBytes = UMLFootprint::jsonBytes(current);
+    totalBytes = currentBytes;
 }
 
 // Saves snapshot in undo stack, call before changes to UMLData
 void UMLDataHistory::save(UMLData& data)
 {
-  if (data.getJson() == current)
+  UML_TRACE_SCOPE("UMLDataHistory::save");
+  static UMLHistogram& saveTime = UMLMetrics::global().histogram("uml_history_save_seconds",
+    "Time taken to save a history snapshot");
+  UMLTimer timer(saveTime);
+
+  json snapshot = data.getJson(true);
+  if (snapshot == current)
     return;
-  undos.push(current);
-  current = data.getJson();
+  undos.push(std::move(current));
+  undoBytes.push(currentBytes);
+  current = std::move(snapshot);
+  currentBytes = UMLFootprint::jsonBytes(current);
+  totalBytes += currentBytes;
 
-  for(size_t i = 0; i < redo_size(); i++)
+  while (!is_redo_empty())
   {
-    redos.pop();
+    pop_redo();
   }
 }
 
 // Returns from previous snapshot save
 UMLData UMLDataHistory::undo()
 {
+  UML_TRACE_SCOPE("UMLDataHistory::undo");
   if (!is_undo_empty())
   {
     redos.push(current);
+    redoBytes.push(currentBytes);
     current = undos.top();
+    currentBytes = undoBytes.top();
     undos.pop();
+    undoBytes.pop();
   }
 
   return load_current();
@@ -45,11 +65,15 @@ UMLData UMLDataHistory::undo()
 // Returns snapshot before last undo
 UMLData UMLDataHistory::redo()
 {
+  UML_TRACE_SCOPE("UMLDataHistory::redo");
   if (!is_redo_empty())
   {
     undos.push(current);
+    undoBytes.push(currentBytes);
     current = redos.top();
+    currentBytes = redoBytes.top();
     redos.pop();
+    redoBytes.pop();
   }
 
   return load_current();
@@ -75,11 +99,75 @@ size_t UMLDataHistory::redo_size() {
   return redos.size(); 
 }
 
+// Returns the estimated bytes held by every snapshot, current included.
+// Each snapshot is measured once, when it's taken.
+size_t UMLDataHistory::snapshot_bytes() const {
+  return totalBytes;
+}
+
+// Drops the newest redo snapshot
+void UMLDataHistory::pop_redo() {
+  totalBytes -= redoBytes.top();
+  redos.pop();
+  redoBytes.pop();
+}
+
+// Loads the current snapshot, attributes keep the ids they were saved with
 UMLData UMLDataHistory::load_current()
 {
+  UML_TRACE_SCOPE("UMLDataHistory::load_current");
   UMLData data;
   UMLFile::addClasses(data, current);
   UMLFile::addRelationships(data , current);
 
   return data;
-}
\ No newline at end of file
+}
+
+// Copies a stack of snapshots into an array, oldest first
+static json stackToJson(std::stack<json> stack)
+{
+  json list = json::array();
+  while (!stack.empty())
+  {
+    list.push_back(std::move(stack.top()));
+    stack.pop();
+  }
+  std::reverse(list.begin(), list.end());
+  return list;
+}
+
+// Returns the current snapshot and both stacks, oldest first
+json UMLDataHistory::getJson()
+{
+  UML_TRACE_SCOPE("UMLDataHistory::getJson");
+  json j;
+  j["current"] = current;
+  j["undos"] = stackToJson(undos);
+  j["redos"] = stackToJson(redos);
+  return j;
+}
+
+// Replaces the whole history with one returned by getJson
+void UMLDataHistory::setJson(const json& j)
+{
+  UML_TRACE_SCOPE("UMLDataHistory::setJson");
+  current = j.at("current");
+  currentBytes = UMLFootprint::jsonBytes(current);
+  totalBytes = currentBytes;
+  undos = std::stack<json>();
+  undoBytes = std::stack<size_t>();
+  for (const json& snapshot : j.at("undos"))
+  {
+    undos.push(snapshot);
+    undoBytes.push(UMLFootprint::jsonBytes(snapshot));
+    totalBytes += undoBytes.top();
+  }
+  redos = std::stack<json>();
+  redoBytes = std::stack<size_t>();
+  for (const json& snapshot : j.at("redos"))
+  {
+    redos.push(snapshot);
+    redoBytes.push(UMLFootprint::jsonBytes(snapshot));
+    totalBytes += redoBytes.top();
+  }
+}
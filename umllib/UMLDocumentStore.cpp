@@ -0,0 +1,378 @@
+/*
+  Filename   : UMLDocumentStore.cpp
+  Description: Implementation of the GUI's document and session store.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLDocumentStore.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+//--------------------------------------------------------------------
+
+// Document opened when none is named
+const string UMLDocumentStore::DEFAULT_DOCUMENT = "default";
+
+// Memory budget used when none is given
+const size_t UMLDocumentStore::DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+// Limits on documents in memory and on sessions used when none are given
+const size_t UMLDocumentStore::DEFAULT_MAX_DOCUMENTS = 64;
+const size_t UMLDocumentStore::DEFAULT_MAX_SESSIONS = 10000;
+const std::chrono::steady_clock::duration UMLDocumentStore::DEFAULT_SESSION_TIMEOUT = std::chrono::hours (8);
+
+// Extension of evicted documents
+static const string SPOOL_EXTENSION = ".umldoc";
+
+// Extension spool files that could not be read are renamed to, kept for
+// a person to look at rather than failing every load
+static const string QUARANTINE_EXTENSION = ".corrupt";
+
+// Constructor: takes in the document's name and last closed state. Commits
+// are published to the document's own feed.
+UMLDocument::UMLDocument (const string& newName, const json& state)
+: name (newName),
+  model ([this] (unsigned long version, const json& delta) {
+    feed.publish (version, delta.dump());
+  }, state)
+{
+}
+
+// Constructor: takes in where to write evicted documents, how many bytes
+// resident documents may use, how many may be resident, and how many
+// sessions are kept and for how long
+UMLDocumentStore::UMLDocumentStore (const string& newSpoolDirectory, size_t newBudget,
+  size_t newMaxDocuments, size_t newMaxSessions, std::chrono::steady_clock::duration newSessionTimeout)
+: spoolDirectory (newSpoolDirectory),
+  budget (newBudget),
+  maxDocuments (newMaxDocuments),
+  maxSessions (newMaxSessions),
+  sessionTimeout (newSessionTimeout)
+{
+}
+
+// Returns the named document, loading it from disk if it was evicted or
+// creating an empty one if it is new. Documents grow as they are edited,
+// so the budget is checked on every lookup, not just when one is loaded.
+// Files are read, decoded and written without the lock, so a slow or
+// broken one holds up only the requests for that document.
+std::shared_ptr<UMLDocument> UMLDocumentStore::document (const string& name)
+{
+  std::unique_lock<std::mutex> guard (lock);
+  while (true)
+  {
+    settled.wait (guard, [&] { return loading.count (name) == 0 && spooling.count (name) == 0; });
+    auto found = documents.find (name);
+    if (found != documents.end())
+    {
+      recency.splice (recency.begin(), recency, found->second.recent);
+      std::shared_ptr<UMLDocument> document = found->second.document;
+      std::vector<std::shared_ptr<UMLDocument>> victims = evict (name);
+      guard.unlock();
+      spool (victims);
+      return document;
+    }
+
+    // Documents being loaded count too, each will start a writer. Once
+    // room is made the name is looked up again, it may have been loaded
+    // while the lock was released.
+    std::vector<std::shared_ptr<UMLDocument>> victims = evict ("", loading.size() + 1);
+    if (victims.empty())
+      break;
+    guard.unlock();
+    spool (victims);
+    guard.lock();
+  }
+
+  // Documents still being written out keep their writer until closed
+  if (documents.size() + loading.size() + spooling.size() >= maxDocuments)
+    throw std::runtime_error ("Too many documents are open, try again later");
+  loading.insert (name);
+  guard.unlock();
+
+  bool corrupt = false;
+  auto start = std::chrono::steady_clock::now();
+  std::shared_ptr<UMLDocument> document;
+  try
+  {
+    document = rehydrate (name, corrupt);
+  }
+  catch (...)
+  {
+    // Let waiting requests try for themselves
+    guard.lock();
+    loading.erase (name);
+    settled.notify_all();
+    throw;
+  }
+  double milliseconds = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+  bool rehydrated = document != nullptr;
+
+  guard.lock();
+  loading.erase (name);
+  settled.notify_all();
+  if (rehydrated)
+  {
+    ++rehydrations;
+    lastRehydrateMilliseconds = milliseconds;
+    totalRehydrateMilliseconds += milliseconds;
+  }
+  if (corrupt)
+    ++quarantined;
+  if (!document)
+    document = std::make_shared<UMLDocument> (name);
+  recency.push_front (name);
+  documents[name] = Entry {document, recency.begin()};
+  std::vector<std::shared_ptr<UMLDocument>> victims = evict (name);
+  guard.unlock();
+  spool (victims);
+  return document;
+}
+
+// Returns the session with the given id, creating it if it is new or has
+// expired
+std::shared_ptr<UMLSession> UMLDocumentStore::session (const string& id)
+{
+  std::lock_guard<std::mutex> guard (lock);
+  auto now = std::chrono::steady_clock::now();
+  auto found = sessions.find (id);
+  if (found == sessions.end() || now - found->second.used > sessionTimeout)
+  {
+    if (found != sessions.end())
+    {
+      sessionRecency.erase (found->second.recent);
+      sessions.erase (found);
+    }
+    sessionRecency.push_front (id);
+    found = sessions.emplace (id, SessionEntry {std::make_shared<UMLSession>(), now, sessionRecency.begin()}).first;
+  }
+  else
+    sessionRecency.splice (sessionRecency.begin(), sessionRecency, found->second.recent);
+  found->second.used = now;
+  std::shared_ptr<UMLSession> session = found->second.session;
+  expireSessions (now);
+  return session;
+}
+
+// Forgets sessions unused for longer than the timeout, and the least
+// recently used ones past the limit. The oldest are at the back of the
+// recency list, so this stops at the first one still wanted.
+void UMLDocumentStore::expireSessions (std::chrono::steady_clock::time_point now)
+{
+  while (!sessionRecency.empty())
+  {
+    auto oldest = sessions.find (sessionRecency.back());
+    if (sessions.size() <= maxSessions && now - oldest->second.used <= sessionTimeout)
+      break;
+    sessions.erase (oldest);
+    sessionRecency.pop_back();
+  }
+}
+
+// Returns the names of every document, resident or evicted
+json UMLDocumentStore::listDocuments ()
+{
+  std::lock_guard<std::mutex> guard (lock);
+  std::set<string> names (spooling);
+  for (const auto& document : documents)
+    names.insert (document.first);
+  std::error_code error;
+  for (const auto& entry : std::filesystem::directory_iterator (spoolDirectory, error))
+  {
+    if (entry.path().extension() == SPOOL_EXTENSION)
+      names.insert (entry.path().stem().string());
+  }
+  return names;
+}
+
+// Returns residency, eviction and rehydration figures
+json UMLDocumentStore::metrics ()
+{
+  std::lock_guard<std::mutex> guard (lock);
+  size_t bytes = 0;
+  for (const auto& document : documents)
+    bytes += document.second.document->model.footprint();
+  json j;
+  j["resident_documents"] = documents.size();
+  j["resident_bytes"] = bytes;
+  j["budget_bytes"] = budget;
+  j["evictions"] = evictions;
+  j["rehydrations"] = rehydrations;
+  j["quarantined"] = quarantined;
+  j["sessions"] = sessions.size();
+  j["last_rehydrate_ms"] = lastRehydrateMilliseconds;
+  j["average_rehydrate_ms"] = rehydrations ? totalRehydrateMilliseconds / rehydrations : 0.0;
+  return j;
+}
+
+// Returns the documents currently held in memory
+std::vector<std::shared_ptr<UMLDocument>> UMLDocumentStore::residentDocuments ()
+{
+  std::lock_guard<std::mutex> guard (lock);
+  std::vector<std::shared_ptr<UMLDocument>> resident;
+  for (const auto& document : documents)
+    resident.push_back (document.second.document);
+  return resident;
+}
+
+// Path an evicted document is written to
+std::filesystem::path UMLDocumentStore::spoolPath (const string& name) const
+{
+  return spoolDirectory / (name + SPOOL_EXTENSION);
+}
+
+// Loads an evicted document back into memory, or null if there is none. The
+// file is removed once loaded, the document lives in memory again. A file
+// that can't be decoded is set aside and corrupt is set, so the name opens
+// as a new document instead of failing every time. Runs without the lock:
+// while a name is loading no other request reads or writes its file.
+std::shared_ptr<UMLDocument> UMLDocumentStore::rehydrate (const string& name, bool& corrupt)
+{
+  std::filesystem::path path = spoolPath (name);
+  std::ifstream file (path, std::ios::binary);
+  if (!file)
+    return nullptr;
+
+  std::vector<std::uint8_t> bytes ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char>());
+  file.close();
+  std::shared_ptr<UMLDocument> document;
+  std::error_code error;
+  try
+  {
+    document = std::make_shared<UMLDocument> (name, json::from_msgpack (bytes));
+  }
+  catch (const std::exception& decodeError)
+  {
+    corrupt = true;
+    std::filesystem::path quarantine = path;
+    quarantine += QUARANTINE_EXTENSION;
+    std::filesystem::rename (path, quarantine, error);
+    return nullptr;
+  }
+  std::filesystem::remove (path, error);
+  return document;
+}
+
+// Closes evicted documents and writes them to disk, keeping any that could
+// not be written. MessagePack keeps the history's many snapshots smaller
+// than json text would. A document that was never edited is just dropped,
+// so opening many names can't fill the disk. Called without the lock:
+// stopping the writer and encoding the history take a while, and the
+// spooling set keeps requests for these names waiting until they finish.
+void UMLDocumentStore::spool (const std::vector<std::shared_ptr<UMLDocument>>& victims)
+{
+  for (const std::shared_ptr<UMLDocument>& victim : victims)
+  {
+    const string& name = victim->name;
+    json state = victim->model.close();
+    bool written = true;
+    if (state.at ("version") != 0)
+    {
+      try
+      {
+        std::filesystem::create_directories (spoolDirectory);
+        std::filesystem::path path = spoolPath (name);
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+        {
+          std::vector<std::uint8_t> bytes = json::to_msgpack (state);
+          std::ofstream file (temporary, std::ios::binary | std::ios::trunc);
+          file.write (reinterpret_cast<const char*> (bytes.data()), bytes.size());
+          if (!file)
+            throw std::runtime_error ("Could not write " + temporary.string());
+        }
+        // Replaced in one step so a crash never leaves half a document behind
+        std::filesystem::rename (temporary, path);
+      }
+      catch (const std::exception& error)
+      {
+        written = false;
+      }
+    }
+
+    // Kept in memory if it couldn't be written, reopened from its closed
+    // state as the least recently used document
+    std::shared_ptr<UMLDocument> kept;
+    if (!written)
+      kept = std::make_shared<UMLDocument> (name, state);
+    std::lock_guard<std::mutex> guard (lock);
+    if (kept)
+    {
+      recency.push_back (name);
+      documents[name] = Entry {kept, std::prev (recency.end())};
+    }
+    else
+      ++evictions;
+    spooling.erase (name);
+    settled.notify_all();
+  }
+}
+
+// Takes idle documents out of memory, least recently used first, until
+// under budget with room for incoming more documents. A document is idle
+// when only the store holds it: no request is using it and no browser is
+// subscribed to its changes. The documents are returned for spool to write
+// once the lock is released.
+std::vector<std::shared_ptr<UMLDocument>> UMLDocumentStore::evict (const string& keep, size_t incoming)
+{
+  std::vector<std::shared_ptr<UMLDocument>> victims;
+  size_t bytes = 0;
+  for (const auto& document : documents)
+    bytes += document.second.document->model.footprint();
+  auto over = [&] {
+    return bytes > budget || documents.size() + incoming > maxDocuments;
+  };
+  if (!over())
+    return victims;
+
+  // Copied, evicting removes names from the list
+  std::vector<string> oldestFirst (recency.rbegin(), recency.rend());
+  for (const string& name : oldestFirst)
+  {
+    if (!over())
+      break;
+    Entry& entry = documents.at (name);
+    if (name == keep || entry.document.use_count() > 1)
+      continue;
+    bytes -= entry.document->model.footprint();
+    victims.push_back (std::move (entry.document));
+    recency.erase (entry.recent);
+    documents.erase (name);
+    spooling.insert (name);
+  }
+  return victims;
+}
+
+// Returns true if name can be used for a document: letters, digits and
+// underscores, the same as class names
+bool UMLDocumentStore::isValidName (const string& name)
+{
+  if (name.empty() || name.size() > 64)
+    return false;
+  for (char c : name)
+  {
+    if (!std::isalnum (static_cast<unsigned char> (c)) && c != '_')
+      return false;
+  }
+  return true;
+}
+
+// Creates a random, unguessable session id
+string UMLDocumentStore::newSessionId ()
+{
+  static const char digits[] = "0123456789abcdef";
+  std::random_device device;
+  string id;
+  for (int i = 0; i < 32; i += 8)
+  {
+    unsigned int bits = device();
+    for (int j = 0; j < 8; ++j, bits >>= 4)
+      id += digits[bits & 0xf];
+  }
+  return id;
+}
@@ -0,0 +1,27 @@
+/*
+  Filename   : UMLEmbeddedFiles.cpp
+  Description: Lookups into the generated table of embedded files.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLEmbeddedFiles.hpp"
+//--------------------------------------------------------------------
+
+// Copies the contents out as a string
+string UMLEmbeddedFile::contents() const
+{
+  return string(reinterpret_cast<const char*>(data), size);
+}
+
+// Finds a file by its path from the repository root, null if it wasn't
+// embedded. There are only a handful, so a scan is as quick as a map.
+const UMLEmbeddedFile* UMLEmbeddedFiles::find(const string& name)
+{
+  for (const UMLEmbeddedFile& file : all())
+  {
+    if (name == file.name)
+      return &file;
+  }
+  return nullptr;
+}
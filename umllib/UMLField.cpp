@@ -24,4 +24,10 @@ UMLField::UMLField(string newName, string newType)
 string UMLField::identifier() const
 {
 	return "field";
+}
+
+// Returns a separate copy of the field, id included
+std::shared_ptr<UMLAttribute> UMLField::clone() const
+{
+	return std::make_shared<UMLField>(*this);
 }
\ No newline at end of file
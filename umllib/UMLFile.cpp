@@ -11,9 +11,10 @@
 #include "include/UMLParameter.hpp"
 #include "include/UMLRelationship.hpp"
 #include "include/UMLField.hpp"
+#include "include/UMLSaveCatalog.hpp"
+#include "include/UMLTrace.hpp"
 
 #include <memory>
-#include <filesystem>
 //--------------------------------------------------------------------
 
 // Constructor: takes in the name of the file to save
@@ -25,17 +26,23 @@ UMLFile::UMLFile(const string& newpath)
 // Saves information from UML diagram to JSON
 void UMLFile::save(UMLData& data)
 {
+  UML_TRACE_SCOPE("UMLFile::save");
   json j = data.getJson();
+  // Leads the file (keys are sorted) so listings only read the header
+  j["class_count"] = j["classes"].size();
 
   std::ofstream file;
   file.open(path);
   file << j.dump(2);
   file.close();
+
+  UMLSaveCatalog::working().touch(path);
 }
 
 // Loads a system file and returns a UML data object
 UMLData UMLFile::load() 
 {
+  UML_TRACE_SCOPE("UMLFile::load");
   std::ifstream file; 
   file.open(path);
   json j;
@@ -52,6 +59,7 @@ UMLData UMLFile::load()
 // Gets the relationships from the json file and adds them to the UMLData object
 void UMLFile::addClasses(UMLData& data, const json& j)
 {
+  UML_TRACE_SCOPE("UMLFile::addClasses");
   for (auto umlclass : j["classes"])
   {
     std::string className = umlclass["name"];
@@ -61,9 +69,13 @@ void UMLFile::addClasses(UMLData& data, const json& j)
     data.getClass(className).setX(umlclass["position_x"]);
     data.getClass(className).setY(umlclass["position_y"]);
 
+    // Attributes keep the ids history snapshots store, files without them
+    // get new ones
     for (auto field : umlclass["fields"])
     {
-      data.addClassAttribute(className, std::make_shared<UMLField>(field["name"], field["type"]));
+      auto ufield = std::make_shared<UMLField>(field["name"], field["type"]);
+      ufield->setId(field.value("id", 0ul));
+      data.addClassAttribute(className, ufield);
     }
     for (auto method : umlclass["methods"])
     {
@@ -71,7 +83,9 @@ void UMLFile::addClasses(UMLData& data, const json& j)
       for (auto param : method["params"])
         params.push_back(UMLParameter(param["name"], param["type"]));
 
-      data.addClassAttribute(className, std::make_shared<UMLMethod>(method["name"], method["return_type"], params));
+      auto umethod = std::make_shared<UMLMethod>(method["name"], method["return_type"], params);
+      umethod->setId(method.value("id", 0ul));
+      data.addClassAttribute(className, umethod);
     }
   }
 }
@@ -79,6 +93,7 @@ void UMLFile::addClasses(UMLData& data, const json& j)
 // Gets the relationships from the json file and adds them to the UMLData object
 void UMLFile::addRelationships(UMLData& data, const json& j)
 {
+  UML_TRACE_SCOPE("UMLFile::addRelationships");
   for (auto relationship : j["relationships"])
   {
     data.addRelationship(relationship["source"], 
@@ -90,17 +105,11 @@ void UMLFile::addRelationships(UMLData& data, const json& j)
 // Makes a list of all JSON files in the build directory that can be used for loading.
 json UMLFile::listSaves()
 {
-  json files = json::array();
-  for (const auto & entry : std::filesystem::directory_iterator("."))
-  {
-    if (entry.path().string().find("json") != std::string::npos && entry.path().string().find("compile_commands") == std::string::npos)
-    {
-      std::string path = entry.path().string();
-      path = path.substr(2, std::string::npos);
-      path = path.substr(0, path.find(".json"));
-      files += path;
-    } 
-  }
-  return files;
+  return UMLSaveCatalog::working().listSaves();
 }
 
+// Lists the saves in the build directory with their size, class count, and modification time.
+json UMLFile::listSaveInfo()
+{
+  return UMLSaveCatalog::working().listSaveInfo();
+}
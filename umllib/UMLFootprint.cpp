@@ -0,0 +1,313 @@
+/*
+  Filename   : UMLFootprint.cpp
+  Description: Implementation of the diagram's memory accounting.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLFootprint.hpp"
+#include "include/UMLClass.hpp"
+#include "include/UMLField.hpp"
+#include "include/UMLMethod.hpp"
+#include "include/UMLParameter.hpp"
+#include "include/UMLRelationship.hpp"
+
+#include <memory>
+#include <utility>
+//--------------------------------------------------------------------
+
+// Reference counts make_shared keeps in the same block as the object
+static const size_t CONTROL_BLOCK_BYTES = sizeof(void*) + 2 * sizeof(int);
+
+// Links of a std::list node
+static const size_t LIST_NODE_BYTES = 2 * sizeof(void*);
+
+// Bytes of an unordered_map node holding the value
+template <typename Value>
+static constexpr size_t hashNodeBytes()
+{
+  return sizeof(void*) + sizeof(Value);
+}
+
+// A class's list node in UMLData, without its name or attributes
+static const size_t CLASS_BYTES = LIST_NODE_BYTES + sizeof(UMLClass);
+
+// A parameter's list node in its method, without its strings
+static const size_t PARAMETER_BYTES = LIST_NODE_BYTES + sizeof(UMLParameter);
+
+// An attribute's shared block and its slot in the class's vector
+static const size_t FIELD_BYTES = CONTROL_BLOCK_BYTES + sizeof(UMLField) + sizeof(std::shared_ptr<UMLAttribute>);
+static const size_t METHOD_BYTES = CONTROL_BLOCK_BYTES + sizeof(UMLMethod) + sizeof(std::shared_ptr<UMLAttribute>);
+
+// The class's lookup entries for an attribute: its slot, and a method's
+// overload number and place among its overloads
+static const size_t SLOT_INDEX_BYTES = hashNodeBytes<std::pair<const unsigned long, size_t>>();
+static const size_t OVERLOAD_INDEX_BYTES = hashNodeBytes<std::pair<const unsigned long, int>>() + sizeof(unsigned long);
+
+// Heap bytes of a string, 0 when it fits in the string itself
+size_t UMLFootprint::heapBytes(const string& text)
+{
+  static const size_t local = string().capacity();
+  return text.size() > local ? text.size() + 1 : 0;
+}
+
+// Bytes of a heap block with the allocator's bookkeeping, 0 for no block
+static size_t blockBytes(size_t bytes)
+{
+  return bytes > 0 ? bytes + UMLFootprint::ALLOCATION_OVERHEAD : 0;
+}
+
+// Estimated bytes of a json value and everything it holds, allocator
+// overhead included. Objects are maps, so each member costs a map node.
+// Arrays are counted as if full, since copies of a snapshot don't keep
+// its spare room.
+size_t UMLFootprint::jsonBytes(const json& value)
+{
+  size_t bytes = sizeof(json);
+  if (value.is_object())
+  {
+    bytes += blockBytes(sizeof(json::object_t));
+    for (const auto& member : value.get_ref<const json::object_t&>())
+    {
+      bytes += ALLOCATION_OVERHEAD + MAP_NODE_BYTES + sizeof(string) + blockBytes(heapBytes(member.first));
+      bytes += jsonBytes(member.second);
+    }
+  }
+  else if (value.is_array())
+  {
+    bytes += blockBytes(sizeof(json::array_t));
+    if (!value.empty())
+      bytes += ALLOCATION_OVERHEAD;
+    for (const json& element : value)
+      bytes += jsonBytes(element);
+  }
+  else if (value.is_string())
+    bytes += blockBytes(sizeof(string)) + blockBytes(heapBytes(value.get_ref<const string&>()));
+  return bytes;
+}
+
+// Counts the heap bytes of a string
+void UMLFootprint::addString(const string& text)
+{
+  size_t bytes = heapBytes(text);
+  if (bytes == 0)
+    return;
+  stringBytes += bytes;
+  ++allocations;
+}
+
+// Drops the heap bytes of a string
+void UMLFootprint::removeString(const string& text)
+{
+  size_t bytes = heapBytes(text);
+  if (bytes == 0)
+    return;
+  stringBytes -= bytes;
+  --allocations;
+}
+
+// Counts a class, without its attributes
+void UMLFootprint::addClass(const UMLClass& uclass)
+{
+  ++classCount;
+  classBytes += CLASS_BYTES;
+  ++allocations;
+  addString(uclass.getName());
+}
+
+// Drops a class, without its attributes
+void UMLFootprint::removeClass(const UMLClass& uclass)
+{
+  --classCount;
+  classBytes -= CLASS_BYTES;
+  --allocations;
+  removeString(uclass.getName());
+}
+
+// Counts an attribute, along with a method's parameters
+void UMLFootprint::addAttribute(const UMLAttribute& attribute)
+{
+  addString(attribute.getAttributeName());
+  addString(attribute.getType());
+  indexBytes += SLOT_INDEX_BYTES;
+  allocations += 2;
+  if (attribute.identifier() != "method")
+  {
+    ++fieldCount;
+    attributeBytes += FIELD_BYTES;
+    return;
+  }
+
+  ++methodCount;
+  attributeBytes += METHOD_BYTES;
+  indexBytes += OVERLOAD_INDEX_BYTES;
+  ++allocations;
+  for (const UMLParameter& param : static_cast<const UMLMethod&>(attribute).getParam())
+    addParameter(param);
+}
+
+// Drops an attribute, along with a method's parameters
+void UMLFootprint::removeAttribute(const UMLAttribute& attribute)
+{
+  removeString(attribute.getAttributeName());
+  removeString(attribute.getType());
+  indexBytes -= SLOT_INDEX_BYTES;
+  allocations -= 2;
+  if (attribute.identifier() != "method")
+  {
+    --fieldCount;
+    attributeBytes -= FIELD_BYTES;
+    return;
+  }
+
+  --methodCount;
+  attributeBytes -= METHOD_BYTES;
+  indexBytes -= OVERLOAD_INDEX_BYTES;
+  --allocations;
+  for (const UMLParameter& param : static_cast<const UMLMethod&>(attribute).getParam())
+    removeParameter(param);
+}
+
+// Counts a method's parameter
+void UMLFootprint::addParameter(const UMLParameter& param)
+{
+  ++parameterCount;
+  parameterBytes += PARAMETER_BYTES;
+  ++allocations;
+  addString(param.getName());
+  addString(param.getType());
+}
+
+// Drops a method's parameter
+void UMLFootprint::removeParameter(const UMLParameter& param)
+{
+  --parameterCount;
+  parameterBytes -= PARAMETER_BYTES;
+  --allocations;
+  removeString(param.getName());
+  removeString(param.getType());
+}
+
+// Swaps the bytes of one stored name for another
+void UMLFootprint::rename(const string& oldName, const string& newName)
+{
+  removeString(oldName);
+  addString(newName);
+}
+
+// Records how many relationships there are and how many the vector has
+// room for
+void UMLFootprint::setRelationships(size_t count, size_t capacity)
+{
+  relationshipCount = count;
+  relationshipCapacity = capacity;
+}
+
+// Records what the name index takes up
+void UMLFootprint::setNameIndex(size_t bytes, size_t blocks)
+{
+  nameIndexBytes = bytes;
+  nameIndexAllocations = blocks;
+}
+
+// Heap bytes of every name and type in the model
+size_t UMLFootprint::getStringBytes() const
+{
+  return stringBytes;
+}
+
+// Bytes of the class objects
+size_t UMLFootprint::getClassBytes() const
+{
+  return classBytes;
+}
+
+// Bytes of the field and method objects
+size_t UMLFootprint::getAttributeBytes() const
+{
+  return attributeBytes;
+}
+
+// Bytes of the methods' parameter lists
+size_t UMLFootprint::getParameterBytes() const
+{
+  return parameterBytes;
+}
+
+// Bytes of the relationship vector, spare room included
+size_t UMLFootprint::getRelationshipBytes() const
+{
+  return relationshipCapacity * sizeof(UMLRelationship);
+}
+
+// Bytes of the classes' attribute lookups and the name index
+size_t UMLFootprint::getIndexBytes() const
+{
+  return indexBytes + nameIndexBytes;
+}
+
+// Bytes the allocator adds to every block counted above
+size_t UMLFootprint::getOverheadBytes() const
+{
+  size_t blocks = allocations + nameIndexAllocations + (relationshipCapacity > 0 ? 1 : 0);
+  return blocks * ALLOCATION_OVERHEAD;
+}
+
+// Bytes of the whole model
+size_t UMLFootprint::getTotalBytes() const
+{
+  return getStringBytes() + getClassBytes() + getAttributeBytes() + getParameterBytes()
+    + getRelationshipBytes() + getIndexBytes() + getOverheadBytes();
+}
+
+// Number of classes
+size_t UMLFootprint::getClassCount() const
+{
+  return classCount;
+}
+
+// Number of fields
+size_t UMLFootprint::getFieldCount() const
+{
+  return fieldCount;
+}
+
+// Number of methods
+size_t UMLFootprint::getMethodCount() const
+{
+  return methodCount;
+}
+
+// Number of parameters across every method
+size_t UMLFootprint::getParameterCount() const
+{
+  return parameterCount;
+}
+
+// Number of relationships
+size_t UMLFootprint::getRelationshipCount() const
+{
+  return relationshipCount;
+}
+
+// Counts and bytes as json, for the stats command and endpoint
+json UMLFootprint::toJson() const
+{
+  json j;
+  j["classes"] = classCount;
+  j["fields"] = fieldCount;
+  j["methods"] = methodCount;
+  j["parameters"] = parameterCount;
+  j["relationships"] = relationshipCount;
+  j["bytes"] = {
+    {"strings", getStringBytes()},
+    {"classes", getClassBytes()},
+    {"attributes", getAttributeBytes()},
+    {"parameters", getParameterBytes()},
+    {"relationships", getRelationshipBytes()},
+    {"indexes", getIndexBytes()},
+    {"overhead", getOverheadBytes()},
+    {"total", getTotalBytes()}
+  };
+  return j;
+}
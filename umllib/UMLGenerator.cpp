@@ -0,0 +1,238 @@
+/*
+  Filename   : UMLGenerator.cpp
+  Description: Implementation of the synthetic diagram generator.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLGenerator.hpp"
+#include "include/UMLFile.hpp"
+#include "include/UMLSaveWriter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+//--------------------------------------------------------------------
+
+// Built in types, used before any made up ones
+static const vector<string> BUILT_IN_TYPES = {"int", "string", "bool", "double", "char", "long", "float", "short"};
+
+// Relationships come from their own generator, so the graph only depends
+// on the seed, class count and shape, and classes can be written first
+static const unsigned long long RELATIONSHIP_SEED = 0x9e3779b97f4a7c15ULL;
+
+// Pixels between classes laid out on a grid
+static const int COLUMN_WIDTH = 300;
+static const int ROW_HEIGHT = 200;
+
+// Even number in [low, high]. The distributions in <random> differ between
+// standard libraries, so they would give different diagrams for a seed.
+static size_t uniform(std::mt19937_64& random, size_t low, size_t high)
+{
+  return low + random() % (high - low + 1);
+}
+
+// True with the given probability
+static bool chance(std::mt19937_64& random, double probability)
+{
+  return (random() >> 11) * 0x1.0p-53 < probability;
+}
+
+// Constructor: throws if the options are out of range
+UMLGenerator::UMLGenerator(const UMLGeneratorOptions& newOptions)
+:options(newOptions)
+{
+  if (options.minFields > options.maxFields
+    || options.minMethods > options.maxMethods
+    || options.minParams > options.maxParams)
+    throw std::runtime_error("Minimum is greater than maximum");
+  if (options.overloadDensity < 0 || options.overloadDensity > 1)
+    throw std::runtime_error("Overload density must be between 0 and 1");
+  if (options.typeCount == 0)
+    throw std::runtime_error("At least one type is needed");
+
+  for (size_t i = 0; i < options.typeCount; ++i)
+  {
+    if (i < BUILT_IN_TYPES.size())
+      types.push_back(BUILT_IN_TYPES[i]);
+    else
+      types.push_back("Type" + std::to_string(i - BUILT_IN_TYPES.size()));
+  }
+}
+
+// Builds the diagram as a model
+UMLData UMLGenerator::generate() const
+{
+  json j;
+  j["classes"] = json::array();
+  j["relationships"] = json::array();
+
+  std::mt19937_64 random(options.seed);
+  for (size_t i = 0; i < options.classes; ++i)
+    j["classes"] += makeClass(i, random);
+  eachRelationship([&] (size_t source, size_t destination, Type type) {
+    j["relationships"] += {
+      {"source", className(source)},
+      {"destination", className(destination)},
+      {"type", UMLRelationship::type_to_string(type)}
+    };
+  });
+
+  UMLData data;
+  UMLFile::addClasses(data, j);
+  UMLFile::addRelationships(data, j);
+  return data;
+}
+
+// Writes the diagram as a save without holding it in memory. Only the
+// graph's bookkeeping grows with the class count.
+void UMLGenerator::write(std::ostream& out) const
+{
+  UMLSaveWriter writer(out, options.classes);
+  std::mt19937_64 random(options.seed);
+  for (size_t i = 0; i < options.classes; ++i)
+    writer.addClass(makeClass(i, random));
+  eachRelationship([&] (size_t source, size_t destination, Type type) {
+    writer.addRelationship({
+      {"source", className(source)},
+      {"destination", className(destination)},
+      {"type", UMLRelationship::type_to_string(type)}
+    });
+  });
+  writer.finish();
+}
+
+// Reads "tree", "dense" or "scale-free"
+UMLGraphShape UMLGenerator::shapeFromString(const string& shape)
+{
+  if (shape == "tree")
+    return UMLGraphShape::tree;
+  if (shape == "dense")
+    return UMLGraphShape::dense;
+  if (shape == "scale-free")
+    return UMLGraphShape::scaleFree;
+  throw std::runtime_error("Unknown graph shape");
+}
+
+// Makes the i'th class in the format of UMLData::getJson, laid out on a
+// square grid
+json UMLGenerator::makeClass(size_t index, std::mt19937_64& random) const
+{
+  size_t columns = std::max<size_t>(1, std::ceil(std::sqrt(options.classes)));
+  json uclass = {
+    {"name", className(index)},
+    {"position_x", int(index % columns) * COLUMN_WIDTH},
+    {"position_y", int(index / columns) * ROW_HEIGHT},
+    {"fields", json::array()},
+    {"methods", json::array()}
+  };
+
+  size_t fieldCount = uniform(random, options.minFields, options.maxFields);
+  for (size_t i = 0; i < fieldCount; ++i)
+    uclass["fields"] += {{"name", "field" + std::to_string(i)}, {"type", types[uniform(random, 0, types.size() - 1)]}};
+
+  // Overloads reuse an earlier method's name. Parameters are compared by
+  // type, so an overload whose types match another's gets more of them.
+  size_t methodCount = uniform(random, options.minMethods, options.maxMethods);
+  vector<string> names;
+  std::map<string, vector<vector<string>>> signatures;
+  for (size_t i = 0; i < methodCount; ++i)
+  {
+    string name;
+    if (!names.empty() && chance(random, options.overloadDensity))
+      name = names[uniform(random, 0, names.size() - 1)];
+    else
+    {
+      name = "method" + std::to_string(names.size());
+      names.push_back(name);
+    }
+
+    json params = makeParams(uniform(random, options.minParams, options.maxParams), random);
+    vector<string> signature;
+    for (const json& param : params)
+      signature.push_back(param["type"]);
+    vector<vector<string>>& taken = signatures[name];
+    while (std::find(taken.begin(), taken.end(), signature) != taken.end())
+    {
+      json extra = makeParams(params.size() + 1, random).back();
+      params += extra;
+      signature.push_back(extra["type"]);
+    }
+    taken.push_back(signature);
+
+    // One past the last type is void, which only return types use
+    size_t returnType = uniform(random, 0, types.size());
+    uclass["methods"] += {
+      {"name", name},
+      {"return_type", returnType == types.size() ? "void" : types[returnType]},
+      {"params", params}
+    };
+  }
+  return uclass;
+}
+
+// Makes a method's parameters
+json UMLGenerator::makeParams(size_t count, std::mt19937_64& random) const
+{
+  json params = json::array();
+  for (size_t i = 0; i < count; ++i)
+    params += {{"name", "param" + std::to_string(i)}, {"type", types[uniform(random, 0, types.size() - 1)]}};
+  return params;
+}
+
+// Calls back with every relationship's source, destination and type. Each
+// class only relates to earlier ones, so a pair is never repeated in either
+// direction. Compositions go to classes that aren't already a composition's
+// destination, the model allows one each.
+void UMLGenerator::eachRelationship(const std::function<void (size_t, size_t, Type)>& callback) const
+{
+  std::mt19937_64 random(options.seed ^ RELATIONSHIP_SEED);
+  vector<bool> composed(options.classes, false);
+  // Both ends of every relationship so far, for picking in proportion to
+  // how related classes are
+  vector<size_t> ends;
+
+  for (size_t i = 1; i < options.classes; ++i)
+  {
+    if (options.shape == UMLGraphShape::tree)
+    {
+      callback(i, uniform(random, 0, i - 1), generalization);
+      continue;
+    }
+
+    vector<size_t> picked;
+    size_t count = std::min(options.degree, i);
+    while (picked.size() < count)
+    {
+      size_t destination;
+      if (options.shape == UMLGraphShape::scaleFree && !ends.empty())
+        destination = ends[uniform(random, 0, ends.size() - 1)];
+      else
+        destination = uniform(random, 0, i - 1);
+      if (std::find(picked.begin(), picked.end(), destination) == picked.end())
+        picked.push_back(destination);
+    }
+
+    for (size_t destination : picked)
+    {
+      Type type = Type(uniform(random, aggregation, realization));
+      if (type == composition && composed[destination])
+        type = aggregation;
+      if (type == composition)
+        composed[destination] = true;
+      callback(i, destination, type);
+      if (options.shape == UMLGraphShape::scaleFree)
+      {
+        ends.push_back(i);
+        ends.push_back(destination);
+      }
+    }
+  }
+}
+
+// Name of the i'th class
+string UMLGenerator::className(size_t index)
+{
+  return "Class" + std::to_string(index);
+}
@@ -0,0 +1,198 @@
+/*
+  Filename   : UMLListFilter.cpp
+  Description: Implementation of the CLI's listing filters.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLListFilter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+//--------------------------------------------------------------------
+
+// Reads the value of a --page or --page-size option
+static size_t parsePositive(const string& option, const string& value)
+{
+  if (value.empty() || value.size() > 9 || !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); }) || std::stoul(value) == 0)
+    throw std::runtime_error(option + " needs a positive number");
+  return std::stoul(value);
+}
+
+// Constructor: parses options such as "--name Shape*" or "--page 2",
+// throws on options that aren't valid for the subject
+UMLListFilter::UMLListFilter(const vector<string>& options, UMLListSubject subject)
+{
+  bool pageGiven = false;
+  for (size_t i = 0; i < options.size(); ++i)
+  {
+    const string& option = options[i];
+    if (option == "--count")
+    {
+      countOnly = true;
+      continue;
+    }
+
+    bool known = option == "--name" || option == "--page" || option == "--page-size"
+      || (option == "--member-type" && subject == UMLListSubject::classes)
+      || (option == "--type" && subject == UMLListSubject::relationships);
+    if (!known)
+      throw std::runtime_error("Unknown option: " + option);
+    if (i + 1 == options.size())
+      throw std::runtime_error(option + " needs a value");
+    const string& value = options[++i];
+
+    if (option == "--name")
+    {
+      name = value;
+      glob = name.find_first_of("*?") != string::npos;
+    }
+    else if (option == "--member-type")
+      memberType = value;
+    else if (option == "--type")
+    {
+      string lower = value;
+      std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+      relationshipType = UMLRelationship::string_to_type(lower);
+      if (relationshipType == none)
+        throw std::runtime_error("Unknown relationship type: " + value);
+    }
+    else if (option == "--page")
+    {
+      page = parsePositive(option, value);
+      pageGiven = true;
+    }
+    else
+      pageSize = parsePositive(option, value);
+  }
+
+  if (pageGiven && pageSize == 0)
+    pageSize = DEFAULT_PAGE_SIZE;
+}
+
+// Returns true if the class passes every filter
+bool UMLListFilter::matches(const UMLClass& uclass) const
+{
+  if (!matchesName(uclass.getName()))
+    return false;
+  if (memberType.empty())
+    return true;
+  for (const auto& attribute : uclass.getAttributes())
+    if (attribute->getType() == memberType)
+      return true;
+  return false;
+}
+
+// Returns true if the relationship passes every filter
+bool UMLListFilter::matches(const UMLRelationship& relationship) const
+{
+  if (relationshipType != none && relationship.getType() != relationshipType)
+    return false;
+  return matchesName(relationship.getSource().getName())
+    || matchesName(relationship.getDestination().getName());
+}
+
+// Returns true if nothing is filtered out
+bool UMLListFilter::unfiltered() const
+{
+  return name.empty() && memberType.empty() && relationshipType == none;
+}
+
+// Returns true if only the number of matches is wanted
+bool UMLListFilter::counting() const
+{
+  return countOnly;
+}
+
+// Returns true if a single page was asked for
+bool UMLListFilter::paged() const
+{
+  return pageSize > 0;
+}
+
+// Position among the matches of the first row of the page
+size_t UMLListFilter::pageStart() const
+{
+  return paged() ? (page - 1) * pageSize : 0;
+}
+
+// Position among the matches one past the last row of the page
+size_t UMLListFilter::pageEnd() const
+{
+  return paged() ? page * pageSize : std::numeric_limits<size_t>::max();
+}
+
+// Number of matching classes. Name prefixes are counted from the name
+// index, only globs and member types need the classes themselves.
+size_t UMLListFilter::countClasses(const UMLData& data) const
+{
+  if (!glob && memberType.empty())
+    return data.getNameIndex().count(UMLNameKind::className, name);
+
+  size_t count = 0;
+  for (const UMLClass& uclass : data.getClasses())
+    if (matches(uclass))
+      ++count;
+  return count;
+}
+
+// Number of matching relationships. Without a name filter the count comes
+// from the model's per-type counts.
+size_t UMLListFilter::countRelationships(const UMLData& data) const
+{
+  if (name.empty())
+  {
+    if (relationshipType == none)
+      return data.getRelationships().size();
+    return data.countRelationships(relationshipType);
+  }
+
+  size_t count = 0;
+  for (const UMLRelationship& relationship : data.getRelationships())
+    if (matches(relationship))
+      ++count;
+  return count;
+}
+
+// Returns true if the class name matches the name filter
+bool UMLListFilter::matchesName(const string& className) const
+{
+  if (glob)
+    return globMatch(name, className);
+  return className.compare(0, name.size(), name) == 0;
+}
+
+// Returns true if the text matches a pattern of * and ? wildcards. On a
+// mismatch after a *, the * takes one more character and matching resumes.
+bool UMLListFilter::globMatch(const string& pattern, const string& text)
+{
+  size_t p = 0;
+  size_t t = 0;
+  size_t star = string::npos;
+  size_t resume = 0;
+  while (t < text.size())
+  {
+    if (p < pattern.size() && pattern[p] == '*')
+    {
+      star = p++;
+      resume = t;
+    }
+    else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+    {
+      ++p;
+      ++t;
+    }
+    else if (star != string::npos)
+    {
+      p = star + 1;
+      t = ++resume;
+    }
+    else
+      return false;
+  }
+  while (p < pattern.size() && pattern[p] == '*')
+    ++p;
+  return p == pattern.size();
+}
@@ -0,0 +1,247 @@
+/*
+  Filename   : UMLLoadGenerator.cpp
+  Description: Implementation of the server load generator.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLLoadGenerator.hpp"
+#include "include/UMLDocumentStore.hpp"
+
+#include <httplib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+//--------------------------------------------------------------------
+
+// Routes of the workload and how often each is picked. Drags and page
+// loads dominate, like a user arranging a diagram.
+static const vector<std::pair<string, unsigned>> MIX = {
+  {"GET /", 20},
+  {"GET /save/data", 15},
+  {"GET /api/v1/model", 5},
+  {"GET /position", 25},
+  {"GET /add/field", 10},
+  {"GET /edit/attribute", 5},
+  {"GET /delete/attribute", 5},
+  {"GET /add/class", 8},
+  {"GET /delete/class", 7}
+};
+
+// Number in [low, high], the same on every standard library (slightly biased)
+static size_t uniform(std::mt19937_64& random, size_t low, size_t high)
+{
+  return low + random() % (high - low + 1);
+}
+
+// Constructor: throws if the options are out of range
+UMLLoadGenerator::UMLLoadGenerator(const UMLLoadOptions& newOptions)
+:options(newOptions)
+{
+  if (options.workers == 0)
+    throw std::runtime_error("At least one worker is needed");
+  if (options.rate < 0)
+    throw std::runtime_error("Rate cannot be negative");
+  if (!UMLDocumentStore::isValidName(options.document))
+    throw std::runtime_error("Document name is not valid");
+}
+
+// Requests a worker sends, in order. Each worker edits a class of its own,
+// which it deletes and adds again first, so the attribute ids it tracks
+// are right even when a run is repeated against the same server.
+vector<UMLLoadRequest> UMLLoadGenerator::plan(size_t worker) const
+{
+  size_t count = options.requests / options.workers + (worker < options.requests % options.workers ? 1 : 0);
+  std::seed_seq sequence {unsigned(options.seed), unsigned(options.seed >> 32), unsigned(worker)};
+  std::mt19937_64 random(sequence);
+
+  string own = "Load" + std::to_string(worker);
+  vector<UMLLoadRequest> requests = {
+    {"GET /delete/class", "/delete/class/" + own},
+    {"GET /add/class", "/add/class?cname=" + own}
+  };
+
+  unsigned total = 0;
+  for (const auto& entry : MIX)
+    total += entry.second;
+
+  // What the worker's edits have left in the model
+  vector<unsigned long> fields;
+  unsigned long nextId = 1;
+  size_t fieldNames = 0;
+  vector<string> added;
+  size_t classNames = 0;
+
+  while (requests.size() < count)
+  {
+    size_t pick = uniform(random, 0, total - 1);
+    size_t choice = 0;
+    while (pick >= MIX[choice].second)
+      pick -= MIX[choice++].second;
+    string route = MIX[choice].first;
+
+    // Edits of things that don't exist yet add them instead
+    if ((route == "GET /edit/attribute" || route == "GET /delete/attribute") && fields.empty())
+      route = "GET /add/field";
+    if (route == "GET /delete/class" && added.empty())
+      route = "GET /add/class";
+
+    string path;
+    if (route == "GET /")
+      path = "/";
+    else if (route == "GET /save/data")
+      path = "/save/data";
+    else if (route == "GET /api/v1/model")
+      path = "/api/v1/model";
+    else if (route == "GET /position")
+      path = "/position/" + own + "/" + std::to_string(uniform(random, 0, 2000)) + "/" + std::to_string(uniform(random, 0, 1200));
+    else if (route == "GET /add/field")
+    {
+      path = "/add/field/" + own + "?fname=field" + std::to_string(fieldNames++) + "&ftype=int";
+      fields.push_back(nextId++);
+    }
+    else if (route == "GET /edit/attribute")
+    {
+      unsigned long id = fields[uniform(random, 0, fields.size() - 1)];
+      path = "/edit/attribute/" + own + "/" + std::to_string(id) + "?name=field" + std::to_string(fieldNames++) + "&type=string";
+    }
+    else if (route == "GET /delete/attribute")
+    {
+      size_t index = uniform(random, 0, fields.size() - 1);
+      path = "/delete/attribute/" + own + "/" + std::to_string(fields[index]);
+      fields.erase(fields.begin() + index);
+    }
+    else if (route == "GET /add/class")
+    {
+      added.push_back(own + "T" + std::to_string(classNames++));
+      path = "/add/class?cname=" + added.back();
+    }
+    else
+    {
+      size_t index = uniform(random, 0, added.size() - 1);
+      path = "/delete/class/" + added[index];
+      added.erase(added.begin() + index);
+    }
+    requests.push_back({route, path});
+  }
+
+  requests.resize(count);
+  return requests;
+}
+
+// Sends every worker's requests and returns the report. Latencies are in
+// milliseconds.
+json UMLLoadGenerator::run() const
+{
+  vector<std::map<string, RouteResults>> results(options.workers);
+  vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t worker = 0; worker < options.workers; ++worker)
+    threads.emplace_back([this, worker, start, &results] { runWorker(worker, start, results[worker]); });
+  for (std::thread& thread : threads)
+    thread.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::map<string, RouteResults> routes;
+  for (const auto& workerResults : results)
+  {
+    for (const auto& route : workerResults)
+    {
+      for (const string& name : {route.first, string("total")})
+      {
+        RouteResults& merged = routes[name];
+        merged.latencies.insert(merged.latencies.end(), route.second.latencies.begin(), route.second.latencies.end());
+        merged.errors += route.second.errors;
+      }
+    }
+  }
+
+  json report = {
+    {"mode", options.rate > 0 ? "open" : "closed"},
+    {"workers", options.workers},
+    {"seed", options.seed},
+    {"seconds", seconds},
+    {"routes", json::object()}
+  };
+  for (auto& route : routes)
+  {
+    vector<double>& latencies = route.second.latencies;
+    std::sort(latencies.begin(), latencies.end());
+    json summary = {
+      {"count", latencies.size()},
+      {"errors", route.second.errors},
+      {"throughput", latencies.size() / seconds},
+      {"p50", percentile(latencies, 0.5) * 1000},
+      {"p99", percentile(latencies, 0.99) * 1000},
+      {"p999", percentile(latencies, 0.999) * 1000}
+    };
+    if (route.first == "total")
+      report["total"] = summary;
+    else
+      report["routes"][route.first] = summary;
+  }
+  return report;
+}
+
+// Value below which the fraction p of sorted values fall, by nearest rank
+double UMLLoadGenerator::percentile(const vector<double>& sorted, double p)
+{
+  if (sorted.empty())
+    return 0;
+  size_t rank = std::ceil(p * sorted.size());
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Sends a worker's requests, adding to its own results. In an open loop a
+// request's latency counts from when it was due, so a slow server's
+// backlog shows up in the percentiles rather than slowing the load.
+void UMLLoadGenerator::runWorker(size_t worker, std::chrono::steady_clock::time_point start,
+  std::map<string, RouteResults>& results) const
+{
+  vector<UMLLoadRequest> requests = plan(worker);
+  vector<double> due = options.rate > 0 ? schedule(worker, requests.size()) : vector<double>();
+
+  // A session of its own, so page errors and views don't mix between workers
+  char session[33];
+  std::snprintf(session, sizeof(session), "%016llx%016llx", options.seed, (unsigned long long) worker);
+  httplib::Headers headers = {{"Cookie", "uml_session=" + string(session) + "; uml_document=" + options.document}};
+
+  httplib::Client client(options.host, options.port);
+  client.set_keep_alive(true);
+  for (size_t i = 0; i < requests.size(); ++i)
+  {
+    auto begin = std::chrono::steady_clock::now();
+    if (!due.empty())
+    {
+      begin = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(due[i]));
+      std::this_thread::sleep_until(begin);
+    }
+    auto result = client.Get(requests[i].path.c_str(), headers);
+    RouteResults& route = results[requests[i].route];
+    route.latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    if (!result || result->status >= 400)
+      ++route.errors;
+  }
+}
+
+// Times at which an open loop worker sends each request, from the start.
+// Gaps are exponential, so requests arrive like independent users'.
+vector<double> UMLLoadGenerator::schedule(size_t worker, size_t count) const
+{
+  std::seed_seq sequence {unsigned(options.seed), unsigned(options.seed >> 32), unsigned(worker), 1u};
+  std::mt19937_64 random(sequence);
+  double perWorker = options.rate / options.workers;
+  vector<double> times;
+  double time = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    time += -std::log(1 - (random() >> 11) * 0x1.0p-53) / perWorker;
+    times.push_back(time);
+  }
+  return times;
+}
@@ -27,7 +27,7 @@ UMLMethod::UMLMethod(string newName, string newType, std::list<UMLParameter> new
 }
 
 // Returns a list of all of the method's parameters
-std::list<UMLParameter> UMLMethod::getParam()
+const std::list<UMLParameter>& UMLMethod::getParam() const
 {
 	return parameterList;
 }
@@ -50,6 +50,12 @@ string UMLMethod::identifier() const
 	return "method";
 }
 
+// Returns a separate copy of the method, id and parameters included
+std::shared_ptr<UMLAttribute> UMLMethod::clone() const
+{
+	return std::make_shared<UMLMethod>(*this);
+}
+
 // Delete parameter from parameter vector
 void UMLMethod::deleteParameter(string name)
 {
@@ -0,0 +1,211 @@
+/*
+  Filename   : UMLMetrics.cpp
+  Description: Implementation of the metrics registry.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLMetrics.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+//--------------------------------------------------------------------
+
+// Constructor: takes in the upper bounds of the buckets, ascending
+UMLHistogram::UMLHistogram(const std::vector<double>& newBounds)
+:bounds(newBounds), buckets(new std::atomic<unsigned long>[newBounds.size() + 1])
+{
+  for (size_t i = 0; i <= bounds.size(); ++i)
+    buckets[i].store(0, std::memory_order_relaxed);
+}
+
+// Records a value. Buckets are few, so a scan beats a binary search.
+void UMLHistogram::observe(double value)
+{
+  size_t bucket = 0;
+  while (bucket < bounds.size() && value > bounds[bucket])
+    ++bucket;
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+  // No fetch_add for doubles until C++20
+  double old = sum.load(std::memory_order_relaxed);
+  while (!sum.compare_exchange_weak(old, old + value, std::memory_order_relaxed))
+  {
+  }
+}
+
+// Returns the number of values recorded
+unsigned long UMLHistogram::getCount() const
+{
+  return count.load(std::memory_order_relaxed);
+}
+
+// Returns the sum of the values recorded
+double UMLHistogram::getSum() const
+{
+  return sum.load(std::memory_order_relaxed);
+}
+
+// Returns the upper bounds and how many values fell at or under each.
+// Values recorded while this runs may be missing from some buckets.
+std::vector<std::pair<double, unsigned long>> UMLHistogram::cumulative() const
+{
+  std::vector<std::pair<double, unsigned long>> totals;
+  unsigned long total = 0;
+  for (size_t i = 0; i < bounds.size(); ++i)
+  {
+    total += buckets[i].load(std::memory_order_relaxed);
+    totals.push_back({bounds[i], total});
+  }
+  return totals;
+}
+
+// Constructor: starts timing into histogram
+UMLTimer::UMLTimer(UMLHistogram& newHistogram)
+:histogram(newHistogram), start(std::chrono::steady_clock::now())
+{
+}
+
+// Destructor: records the elapsed time
+UMLTimer::~UMLTimer()
+{
+  histogram.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+// Upper bounds in seconds used for timings, 100us to 10s
+const std::vector<double> UMLMetrics::LATENCY_BUCKETS = {
+  0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+
+// Upper bounds used for sizes in bytes, 1 KiB to 64 MiB
+const std::vector<double> UMLMetrics::SIZE_BUCKETS = {
+  1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216, 67108864
+};
+
+// Finds or adds a family, throws if it was registered as another type
+UMLMetrics::Family& UMLMetrics::family(const string& name, const string& help, const string& type)
+{
+  Family& found = families[name];
+  if (found.type.empty())
+  {
+    found.help = help;
+    found.type = type;
+  }
+  else if (found.type != type)
+    throw std::runtime_error("Metric " + name + " is already a " + found.type);
+  return found;
+}
+
+// Registers a counter, or returns the one already registered
+UMLCounter& UMLMetrics::counter(const string& name, const string& help, const string& labels)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  UMLCounter*& found = family(name, help, "counter").counters[labels];
+  if (!found)
+  {
+    counters.emplace_back();
+    found = &counters.back();
+  }
+  return *found;
+}
+
+// Registers a gauge, or returns the one already registered
+UMLGauge& UMLMetrics::gauge(const string& name, const string& help, const string& labels)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  UMLGauge*& found = family(name, help, "gauge").gauges[labels];
+  if (!found)
+  {
+    gauges.emplace_back();
+    found = &gauges.back();
+  }
+  return *found;
+}
+
+// Registers a histogram, or returns the one already registered
+UMLHistogram& UMLMetrics::histogram(const string& name, const string& help, const string& labels,
+  const std::vector<double>& bounds)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  UMLHistogram*& found = family(name, help, "histogram").histograms[labels];
+  if (!found)
+  {
+    histograms.emplace_back(bounds);
+    found = &histograms.back();
+  }
+  return *found;
+}
+
+// Writes every metric in Prometheus' text format
+string UMLMetrics::exposition()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  std::ostringstream out;
+  for (const auto& named : families)
+  {
+    const string& name = named.first;
+    const Family& family = named.second;
+    out << "# HELP " << name << " " << family.help << "\n";
+    out << "# TYPE " << name << " " << family.type << "\n";
+    for (const auto& counter : family.counters)
+      out << sample(name, counter.first, counter.second->get());
+    for (const auto& gauge : family.gauges)
+      out << sample(name, gauge.first, gauge.second->get());
+    for (const auto& histogram : family.histograms)
+    {
+      string labels = histogram.first.empty() ? "" : histogram.first + ",";
+      for (const auto& bucket : histogram.second->cumulative())
+      {
+        out << sample(name + "_bucket", labels + "le=" + label(number(bucket.first)), bucket.second);
+      }
+      out << sample(name + "_bucket", labels + "le=\"+Inf\"", histogram.second->getCount());
+      out << sample(name + "_sum", histogram.first, histogram.second->getSum());
+      out << sample(name + "_count", histogram.first, histogram.second->getCount());
+    }
+  }
+  return out.str();
+}
+
+// Writes a single sample line in Prometheus' text format
+string UMLMetrics::sample(const string& name, const string& labels, double value)
+{
+  std::ostringstream out;
+  out << name;
+  if (!labels.empty())
+    out << "{" << labels << "}";
+  out << " " << number(value) << "\n";
+  return out.str();
+}
+
+// Formats a number without losing digits of large counts, or padding
+// small fractions
+string UMLMetrics::number(double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+  return buffer;
+}
+
+// Quotes a label value, escaping what the text format requires
+string UMLMetrics::label(const string& value)
+{
+  string quoted = "\"";
+  for (char c : value)
+  {
+    if (c == '\\' || c == '"')
+      quoted += '\\';
+    if (c == '\n')
+      quoted += "\\n";
+    else
+      quoted += c;
+  }
+  return quoted + "\"";
+}
+
+// Registry the program's metrics are kept in
+UMLMetrics& UMLMetrics::global()
+{
+  static UMLMetrics metrics;
+  return metrics;
+}
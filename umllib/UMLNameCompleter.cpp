@@ -0,0 +1,73 @@
+/*
+  Filename   : UMLNameCompleter.cpp
+  Description: Implementation of the CLI's argument completion.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLNameCompleter.hpp"
+
+#include <cctype>
+#include <sstream>
+//--------------------------------------------------------------------
+
+// Constructor: completes nothing until commands are added. The empty name
+// can't be typed, so the library never lists or runs it.
+UMLNameCompleter::UMLNameCompleter()
+:cli::Command("")
+{
+}
+
+// Completes the arguments of a command with the given sources
+void UMLNameCompleter::add(const string& command, vector<Source> arguments)
+{
+  commands[command] = std::move(arguments);
+}
+
+// Never handles a command, they're left to the menu's other commands
+bool UMLNameCompleter::Exec(const vector<string>& cmdLine, cli::CliSession& session)
+{
+  return false;
+}
+
+// Not a command of its own, so has no help
+void UMLNameCompleter::Help(std::ostream& out) const
+{
+}
+
+// Completions for a line of the menu, as whole lines. Only arguments are
+// completed, the library already completes the command's name.
+vector<string> UMLNameCompleter::GetCompletionRecursive(const string& line) const
+{
+  std::istringstream in(line);
+  vector<string> words;
+  string word;
+  while (in >> word)
+    words.push_back(word);
+
+  // A trailing space means the next argument hasn't been started
+  bool started = !line.empty() && !std::isspace((unsigned char) line.back());
+  if (words.empty() || (words.size() == 1 && started))
+    return {};
+
+  auto command = commands.find(words[0]);
+  if (command == commands.end())
+    return {};
+
+  size_t argument = started ? words.size() - 2 : words.size() - 1;
+  if (argument >= command->second.size() || !command->second[argument])
+    return {};
+
+  string prefix = started ? words.back() : "";
+  vector<string> previous(words.begin() + 1, words.begin() + 1 + argument);
+
+  // Each completion repeats the line up to the argument being completed
+  string typed = words[0] + ' ';
+  for (const string& value : previous)
+    typed += value + ' ';
+
+  vector<string> result;
+  for (const string& value : command->second[argument](previous, prefix))
+    result.push_back(typed + value);
+  return result;
+}
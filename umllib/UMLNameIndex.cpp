@@ -0,0 +1,114 @@
+/*
+  Filename   : UMLNameIndex.cpp
+  Description: Implementation of the diagram's name index.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLNameIndex.hpp"
+#include "include/UMLFootprint.hpp"
+//--------------------------------------------------------------------
+
+// Counts a use of the name
+void UMLNameIndex::add(UMLNameKind kind, const string& name)
+{
+  auto found = names[(size_t) kind].emplace(name, 0);
+  if (found.second)
+    addNode(name);
+  ++found.first->second;
+}
+
+// Drops a use of the name, removing it after its last use
+void UMLNameIndex::remove(UMLNameKind kind, const string& name)
+{
+  std::map<string, size_t>& kindNames = names[(size_t) kind];
+  auto found = kindNames.find(name);
+  if (found == kindNames.end())
+    return;
+  if (--found->second == 0)
+  {
+    removeNode(name);
+    kindNames.erase(found);
+  }
+}
+
+// Swaps one use of a name for another
+void UMLNameIndex::rename(UMLNameKind kind, const string& oldName, const string& newName)
+{
+  remove(kind, oldName);
+  add(kind, newName);
+}
+
+// Names of the kind starting with the prefix, in sorted order. Every name
+// with the prefix sorts at or after it, so the search starts there and
+// stops at the first name without it.
+vector<string> UMLNameIndex::complete(UMLNameKind kind, const string& prefix, size_t limit) const
+{
+  const std::map<string, size_t>& kindNames = names[(size_t) kind];
+  vector<string> result;
+  for (auto name = kindNames.lower_bound(prefix);
+    name != kindNames.end() && result.size() < limit && name->first.compare(0, prefix.size(), prefix) == 0;
+    ++name)
+  {
+    result.push_back(name->first);
+  }
+  return result;
+}
+
+// Number of distinct names of the kind starting with the prefix. Only the
+// matching names are walked, and without copying them.
+size_t UMLNameIndex::count(UMLNameKind kind, const string& prefix) const
+{
+  const std::map<string, size_t>& kindNames = names[(size_t) kind];
+  if (prefix.empty())
+    return kindNames.size();
+  size_t result = 0;
+  for (auto name = kindNames.lower_bound(prefix);
+    name != kindNames.end() && name->first.compare(0, prefix.size(), prefix) == 0;
+    ++name)
+  {
+    ++result;
+  }
+  return result;
+}
+
+// Returns true if some part of the model uses the name
+bool UMLNameIndex::contains(UMLNameKind kind, const string& name) const
+{
+  return names[(size_t) kind].count(name) > 0;
+}
+
+// Number of distinct names of the kind
+size_t UMLNameIndex::size(UMLNameKind kind) const
+{
+  return names[(size_t) kind].size();
+}
+
+// Bytes the index's nodes and names take up
+size_t UMLNameIndex::bytes() const
+{
+  return nodeBytes;
+}
+
+// Heap blocks behind the index's nodes and their names
+size_t UMLNameIndex::allocations() const
+{
+  return nodeBlocks;
+}
+
+// Counts the memory of a new name's node, and of the name if it's too
+// long to be kept in the node
+void UMLNameIndex::addNode(const string& name)
+{
+  size_t nameBytes = UMLFootprint::heapBytes(name);
+  nodeBytes += UMLFootprint::MAP_NODE_BYTES + sizeof(std::pair<const string, size_t>) + nameBytes;
+  nodeBlocks += nameBytes > 0 ? 2 : 1;
+}
+
+// Drops the memory of a name's node
+void UMLNameIndex::removeNode(const string& name)
+{
+  size_t nameBytes = UMLFootprint::heapBytes(name);
+  nodeBytes -= UMLFootprint::MAP_NODE_BYTES + sizeof(std::pair<const string, size_t>) + nameBytes;
+  nodeBlocks -= nameBytes > 0 ? 2 : 1;
+}
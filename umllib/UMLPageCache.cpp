@@ -0,0 +1,65 @@
+/*
+  Filename   : UMLPageCache.cpp
+  Description: Implementation of the rendered page cache.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLPageCache.hpp"
+#include "include/UMLCompression.hpp"
+
+#include <functional>
+#include <sstream>
+//--------------------------------------------------------------------
+
+// Returns the cached page for key if it was rendered at version and
+// generation, otherwise null
+std::shared_ptr<const UMLPage> UMLPageCache::find(const string& key, unsigned long version, unsigned long generation)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = pages.find(key);
+  if (found == pages.end() || found->second->version != version || found->second->generation != generation)
+    return nullptr;
+  return found->second;
+}
+
+// Stores a freshly rendered page, replacing any older version or
+// generation of it. Large pages are compressed here once, not again for
+// every request that hits.
+std::shared_ptr<const UMLPage> UMLPageCache::store(const string& key, unsigned long version, string body, unsigned long generation)
+{
+  string etag = makeETag(version, body);
+  string gzipped;
+  if (body.size() >= UMLCompression::MIN_SIZE)
+    gzipped = UMLCompression::gzip(body);
+  auto page = std::make_shared<const UMLPage>(UMLPage{version, generation, std::move(body), std::move(etag), std::move(gzipped)});
+  std::lock_guard<std::mutex> guard(lock);
+  pages[key] = page;
+  return page;
+}
+
+// Drops every cached page
+void UMLPageCache::clear()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  pages.clear();
+}
+
+// Creates a strong ETag from the page's version and contents. The content
+// hash keeps tags distinct across server restarts, when versions start over.
+string UMLPageCache::makeETag(unsigned long version, const string& body)
+{
+  std::ostringstream etag;
+  etag << "\"" << version << "-" << std::hex << std::hash<string>{}(body) << "\"";
+  return etag.str();
+}
+
+// Checks an If-None-Match header value against an ETag
+bool UMLPageCache::matches(const string& ifNoneMatch, const string& etag)
+{
+  if (ifNoneMatch.empty())
+    return false;
+  if (ifNoneMatch == "*")
+    return true;
+  return ifNoneMatch.find(etag) != string::npos;
+}
@@ -22,7 +22,7 @@ UMLParameter::UMLParameter(string name, string type)
 }
 
 // Grab name of the given parameter
-string UMLParameter::getName() const
+const string& UMLParameter::getName() const
 {
 	return name;
 }
@@ -34,7 +34,7 @@ void UMLParameter::changeName(string newName)
 }
 
 // Grab type of the given parameter
-string UMLParameter::getType() const
+const string& UMLParameter::getType() const
 {
 	return type;
 }
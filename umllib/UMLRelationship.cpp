@@ -50,6 +50,23 @@ Type UMLRelationship::string_to_type(const std::string& typeIn)
     }
 }
 
+// Converts type enum to its string name
+std::string UMLRelationship::type_to_string(Type typeIn)
+{
+    switch (typeIn) {
+      case aggregation :
+        return "aggregation";
+      case composition :
+        return "composition";
+      case generalization :
+        return "generalization";
+      case realization :
+        return "realization";
+      default :
+        return "none";
+    }
+}
+
 // Set type of relationship
 void UMLRelationship::setType(int newType) {
   if (newType == 0) {
@@ -0,0 +1,242 @@
+/*
+  Filename   : UMLSaveCatalog.cpp
+  Description: Implementation of the save file catalog.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLSaveCatalog.hpp"
+
+#include <chrono>
+#include <fstream>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+namespace fs = std::filesystem;
+//--------------------------------------------------------------------
+
+// Longest a modification time can stay the same across changes. Most
+// filesystems keep nanoseconds, but some only keep every other second.
+static const auto MODIFIED_TICK = std::chrono::seconds(2);
+
+// Shortest time between two looks at the directory
+static const auto CHECK_INTERVAL = std::chrono::seconds(1);
+
+// Compares everything listed about a save
+bool UMLSaveCatalog::SaveInfo::operator==(const SaveInfo& other) const
+{
+  return size == other.size && classCount == other.classCount && modified == other.modified;
+}
+
+// Constructor: takes in the directory to catalog
+UMLSaveCatalog::UMLSaveCatalog(const string& newDirectory)
+:directory(newDirectory)
+{
+}
+
+// Returns the names (no extension) of all saves in the directory
+json UMLSaveCatalog::listSaves()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  refresh();
+  return *names;
+}
+
+// Returns name, size, class count, and modification time for each save
+json UMLSaveCatalog::listSaveInfo()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  refresh();
+  return *details;
+}
+
+// Returns a counter that changes whenever the listings change
+unsigned long UMLSaveCatalog::generation()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  refresh();
+  return listingGeneration;
+}
+
+// Returns the names of all saves and their generation in one go
+UMLSaveCatalog::Listing UMLSaveCatalog::listing()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  refresh();
+  return {names, listingGeneration};
+}
+
+// Updates a single file after it has been written
+void UMLSaveCatalog::touch(const string& path)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  std::error_code error;
+  fs::path parent = fs::path(path).parent_path();
+  if (parent.empty())
+    parent = ".";
+  // Files outside of the catalogued directory are not listed
+  if (!fs::equivalent(parent, directory, error))
+    return;
+  if (!stale && updateEntry(fs::path(path)))
+    rebuildListings();
+}
+
+// Forces a full rescan on the next listing
+void UMLSaveCatalog::invalidate()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  stale = true;
+}
+
+// Catalog of the working directory shared by UMLFile
+UMLSaveCatalog& UMLSaveCatalog::working()
+{
+  static UMLSaveCatalog catalog(".");
+  return catalog;
+}
+
+// Rebuilds the catalog from the directory if it changed. Writes made
+// through UMLFile are applied by touch(), so the directory only needs to
+// be looked at for saves added, removed or renamed some other way, and
+// then at most once per CHECK_INTERVAL. Its modification time can miss a
+// change made in the same tick as the last scan, so a recently changed
+// directory is rescanned on the next check too. Listings are only
+// rebuilt, and the generation only bumped, when something listed changed.
+void UMLSaveCatalog::refresh()
+{
+  auto now = std::chrono::steady_clock::now();
+  if (!stale && now - lastChecked < CHECK_INTERVAL)
+    return;
+  lastChecked = now;
+
+  std::error_code error;
+  fs::file_time_type modified = fs::last_write_time(directory, error);
+  if (error)
+    return;
+  if (!stale && modified == directoryModified && !isRecent(modified))
+    return;
+
+  std::map<string, SaveInfo> previous;
+  previous.swap(saves);
+  for (const auto& entry : fs::directory_iterator(directory, error))
+  {
+    if (!isSave(entry.path()))
+      continue;
+    // Unchanged files keep their cached header information
+    string name = entry.path().stem().string();
+    auto old = previous.find(name);
+    std::error_code entryError;
+    if (old != previous.end()
+      && !isRecent(old->second.modified)
+      && old->second.modified == entry.last_write_time(entryError)
+      && old->second.size == entry.file_size(entryError))
+      saves[name] = old->second;
+    else
+      updateEntry(entry.path());
+  }
+
+  directoryModified = modified;
+  if (stale || saves != previous)
+    rebuildListings();
+  stale = false;
+}
+
+// Re-reads a single entry, returns false if the path is not a save
+bool UMLSaveCatalog::updateEntry(const fs::path& path)
+{
+  if (!isSave(path))
+    return false;
+
+  string name = path.stem().string();
+  std::error_code error;
+  SaveInfo info;
+  info.size = fs::file_size(path, error);
+  if (!error)
+    info.modified = fs::last_write_time(path, error);
+  if (error)
+  {
+    saves.erase(name);
+    return true;
+  }
+  info.classCount = readClassCount(path);
+  saves[name] = info;
+  return true;
+}
+
+// Regenerates the cached json listings from the save map
+void UMLSaveCatalog::rebuildListings()
+{
+  ++listingGeneration;
+  json newNames = json::array();
+  json newDetails = json::array();
+  for (const auto& save : saves)
+  {
+    // Convert the file clock into seconds since the epoch for display
+    auto modified = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+      save.second.modified - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+    long long seconds = std::chrono::duration_cast<std::chrono::seconds>(modified.time_since_epoch()).count();
+
+    newNames += save.first;
+    newDetails += {
+      {"name", save.first},
+      {"size", save.second.size},
+      {"classes", save.second.classCount},
+      {"modified", seconds}
+    };
+  }
+  names = std::make_shared<const json>(std::move(newNames));
+  details = std::make_shared<const json>(std::move(newDetails));
+}
+
+// Returns true if the path looks like a loadable save
+bool UMLSaveCatalog::isSave(const fs::path& path)
+{
+  return path.extension() == ".json" && path.stem() != "compile_commands";
+}
+
+// Returns true if something could still change without the modification
+// time moving on from this one
+bool UMLSaveCatalog::isRecent(fs::file_time_type modified)
+{
+  return fs::file_time_type::clock::now() - modified < MODIFIED_TICK;
+}
+
+// Reads the class count out of a save's header. Saves written by UMLFile
+// lead with "class_count", so only the first few bytes need to be read.
+// Older saves without the header are parsed in full once.
+size_t UMLSaveCatalog::readClassCount(const fs::path& path)
+{
+  std::ifstream file(path);
+  char header[128] = {};
+  file.read(header, sizeof(header) - 1);
+  string start(header, file.gcount());
+
+  const string key = "\"class_count\":";
+  size_t location = start.find(key);
+  if (location != string::npos)
+  {
+    try
+    {
+      return std::stoul(start.substr(location + key.size()));
+    }
+    catch (const std::exception& error)
+    {
+      // Fall through to a full parse
+    }
+  }
+
+  try
+  {
+    file.clear();
+    file.seekg(0);
+    json j = json::parse(file);
+    if (j.contains("classes"))
+      return j["classes"].size();
+  }
+  catch (const std::exception& error)
+  {
+    // Not a diagram, still listed so the user can see it
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+/*
+  Filename   : UMLSaveWriter.cpp
+  Description: Implementation of the streaming save writer.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLSaveWriter.hpp"
+
+#include <stdexcept>
+//--------------------------------------------------------------------
+
+// Constructor: writes the header, which needs the number of classes. Keys
+// go in the order json::dump sorts them, so "class_count" leads the file
+// like it does in saves written by UMLFile.
+UMLSaveWriter::UMLSaveWriter(std::ostream& newOut, size_t newClassCount)
+:out(newOut), classCount(newClassCount)
+{
+  out << "{\"class_count\":" << classCount << ",\"classes\":[";
+}
+
+// Writes a class in the format of UMLData::getJson
+void UMLSaveWriter::addClass(const json& uclass)
+{
+  if (finished || relationshipsWritten > 0 || classesWritten == classCount)
+    throw std::runtime_error("More classes written than the save's class count");
+  if (classesWritten > 0)
+    out << ',';
+  out << uclass.dump();
+  ++classesWritten;
+}
+
+// Writes a relationship, all classes must have been written first
+void UMLSaveWriter::addRelationship(const json& relationship)
+{
+  if (finished)
+    throw std::runtime_error("Save is already finished");
+  if (relationshipsWritten == 0)
+    endClasses();
+  else
+    out << ',';
+  out << relationship.dump();
+  ++relationshipsWritten;
+}
+
+// Closes the save, throws if fewer classes were written than promised
+void UMLSaveWriter::finish()
+{
+  if (finished)
+    return;
+  if (relationshipsWritten == 0)
+    endClasses();
+  out << "]}";
+  out.flush();
+  finished = true;
+  if (!out)
+    throw std::runtime_error("Save could not be written");
+}
+
+// Number of classes written so far
+size_t UMLSaveWriter::classes() const
+{
+  return classesWritten;
+}
+
+// Number of relationships written so far
+size_t UMLSaveWriter::relationships() const
+{
+  return relationshipsWritten;
+}
+
+// Closes the class list and opens the relationship list
+void UMLSaveWriter::endClasses()
+{
+  if (classesWritten != classCount)
+    throw std::runtime_error("Fewer classes written than the save's class count");
+  out << "],\"relationships\":[";
+}
@@ -3,117 +3,324 @@
   Description: Implementation of a GUI controller/server.
 */
 
+#include <algorithm>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include "UMLAttribute.hpp"
+#include "UMLCompression.hpp"
 #include "UMLData.hpp"
 #include "UMLDataHistory.hpp"
 #include "UMLField.hpp"
 #include "UMLFile.hpp"
 #include "UMLMethod.hpp"
+#include "UMLMetrics.hpp"
+#include "UMLSaveCatalog.hpp"
+#include "UMLTrace.hpp"
 #include "include/UMLServer.hpp"
 
 #include <httplib.h>
-#include <inja/inja.hpp>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
-// Catch for functions to protect from invalid inputs
-#define ERR_ADD(fun)                      \
-  try                                     \
-  {                                       \
+// Catch for functions to protect from invalid inputs, publishing the delta
+// the edit made
+#define ERR_ADD(fun, delta)               \
+  pageEdit (context, [&] (UMLData& data) {\
     fun;                                  \
-    history.save (data);                  \
-  }                                       \
-  catch (const std::exception& error)     \
-  {                                       \
-    errors += error.what();               \
-  }                                       \
+    return delta;                         \
+  });
+
+// Sends a body, gzipped when the client accepts it and it is large enough
+// to be worth compressing
+static void sendContent (const httplib::Request& req, httplib::Response& res, const std::string& body, const char* type)
+{
+  if (body.size() < UMLCompression::MIN_SIZE || !UMLCompression::isCompressible (type))
+  {
+    res.set_content (body, type);
+    return;
+  }
+  res.set_header ("Vary", "Accept-Encoding");
+  if (UMLCompression::acceptsGzip (req.get_header_value ("Accept-Encoding")))
+  {
+    res.set_header ("Content-Encoding", "gzip");
+    res.set_content (UMLCompression::gzip (body), type);
+  }
+  else
+    res.set_content (body, type);
+}
+
+// Sends a body that was compressed ahead of time, or 304 if the client
+// already has it. The gzip copy is a different representation, so it gets
+// its own ETag.
+static void sendStored (const httplib::Request& req, httplib::Response& res, const std::string& body,
+  const std::string& gzipped, const std::string& etag, const char* type)
+{
+  bool gzip = !gzipped.empty() && UMLCompression::acceptsGzip (req.get_header_value ("Accept-Encoding"));
+  std::string tag = gzip ? etag.substr (0, etag.size() - 1) + "-gz\"" : etag;
+  res.set_header ("ETag", tag);
+  if (!gzipped.empty())
+    res.set_header ("Vary", "Accept-Encoding");
+  if (UMLPageCache::matches (req.get_header_value ("If-None-Match"), tag))
+  {
+    res.status = 304;
+    return;
+  }
+  if (gzip)
+  {
+    res.set_header ("Content-Encoding", "gzip");
+    res.set_content (gzipped, type);
+  }
+  else
+    res.set_content (body, type);
+}
+
+// Sends a cached page, or 304 if the client already has this version of it
+static void sendPage (const httplib::Request& req, httplib::Response& res, const UMLPage& page, const char* type)
+{
+  // Clients must revalidate, the page changes with every edit
+  res.set_header ("Cache-Control", "no-cache");
+  sendStored (req, res, page.body, page.gzipped, page.etag, type);
+}
+
+// Lists the relationships of a class as source/destination pairs
+static json relationshipKeys (UMLData& data, const std::string& className)
+{
+  json keys = json::array();
+  for (const UMLRelationship& relationship : data.getRelationshipsByClass (className))
+  {
+    keys += {{"source", relationship.getSource().getName()}, {"destination", relationship.getDestination().getName()}};
+  }
+  return keys;
+}
+
+// Delta holding a single changed class
+static json classDelta (UMLData& data, const std::string& className)
+{
+  json delta;
+  delta["classes"] = json::array ({UMLServer::classJson (data.getClass (className))});
+  return delta;
+}
+
+// Delta holding a single changed relationship
+static json relationshipDelta (UMLData& data, const std::string& source, const std::string& destination)
+{
+  json delta;
+  delta["relationships"] = json::array ({UMLServer::relationshipJson (data.getRelationship (source, destination))});
+  return delta;
+}
+
+// Renames a class. The delta drops the old class and its relationships and
+// adds them back under the new name.
+static json renameClass (UMLData& data, const std::string& oldName, const std::string& newName)
+{
+  json oldRelationships = relationshipKeys (data, oldName);
+  data.changeClassName (oldName, newName);
+  json delta = classDelta (data, newName);
+  delta["deleted"]["classes"] = json::array ({oldName});
+  delta["deleted"]["relationships"] = oldRelationships;
+  delta["relationships"] = json::array();
+  for (const UMLRelationship& relationship : data.getRelationshipsByClass (newName))
+    delta["relationships"] += UMLServer::relationshipJson (relationship);
+  return delta;
+}
+
+// Deletes a class, the delta drops it and its relationships
+static json deleteClass (UMLData& data, const std::string& className)
+{
+  json delta;
+  delta["deleted"]["relationships"] = relationshipKeys (data, className);
+  data.deleteClass (className);
+  delta["deleted"]["classes"] = json::array ({className});
+  return delta;
+}
+
+// Delta dropping a single relationship
+static json deletedRelationshipDelta (const std::string& source, const std::string& destination)
+{
+  json delta;
+  delta["deleted"]["relationships"] = json::array ({{{"source", source}, {"destination", destination}}});
+  return delta;
+}
+
+// Finds the attribute with an id within a class
+static attr_ptr attributeAt (UMLData& data, const std::string& className, unsigned long id)
+{
+  return data.getClass (className).getAttributeById (id);
+}
+
+// Finds the method with an id within a class
+static method_ptr methodAt (UMLData& data, const std::string& className, unsigned long id)
+{
+  attr_ptr attr = attributeAt (data, className, id);
+  if (attr->identifier() != "method")
+    throw std::runtime_error ("Method not found");
+  return std::static_pointer_cast<UMLMethod> (attr);
+}
+
+// Cookies naming the document and session of a browser
+static const std::string DOCUMENT_COOKIE = "uml_document";
+static const std::string SESSION_COOKIE = "uml_session";
+
+// Templates and static files, named from the repository root. They are
+// compiled into the program; dev mode reads them from SOURCE_ROOT instead.
+static const std::string INDEX_TEMPLATE = "templates/index.html";
+static const std::string HELP_TEMPLATE = "helpGUI.html";
+static const std::string STATIC_DIRECTORY = "static";
+
+// The repository root relative to the build directory
+static const std::string SOURCE_ROOT = "../";
+
+// Constructor: dev mode reads templates and static files from disk, and
+// reloads them when they change
+UMLServer::UMLServer (bool devMode)
+: templates (devMode, SOURCE_ROOT), assets (devMode, SOURCE_ROOT)
+{
+}
 
 // Controller management for the GUI
 void UMLServer::start (int port)
 {
+  // Parse templates once up front rather than on every request
+  templates.load (INDEX_TEMPLATE);
+  templates.load (HELP_TEMPLATE);
+  // Static files are read and compressed once, rather than per request
+  assets.load (STATIC_DIRECTORY);
+
   httplib::Server svr;
-  svr.set_mount_point ("/", "../static");
-  UMLData data;
-  UMLDataHistory history (data);
-  // Create view for focusing certain elements in sidebar
-  json view;
-  view["object"] = "all";
-  view["name"] = "";
-  view["name2"] = "";
-  json errors = json::array();
-  json success = json::array();
-
-  svr.Get ("/", [&] (const httplib::Request& req, httplib::Response& res) {
-    inja::Environment env;
-    inja::Template temp = env.parse_template ("../templates/index.html");
-    json j = data.getJson();
-    // for each for all the attributes in each class add the index number to the json object
-    addAttributeIndexes (j, data);
-    j["errors"] = errors;
-    errors.clear();
-    j["success"] = success;
-    success.clear();
-    j["files"] = UMLFile::listSaves();
-    j["view"] = view;
-    // passing in raw json string for downloading
-    j["raw_json_string"] = data.getJson().dump();
-    res.set_content (env.render (temp, j), "text/html");
-  });
-
-  svr.Get ("/add/class", [&] (const httplib::Request& req, httplib::Response& res) {
+  // Requests no longer race on the model, and each open change stream holds
+  // a worker, so allow more workers than httplib's default
+  svr.new_task_queue = [] {
+    return new httplib::ThreadPool (std::max (16u, std::thread::hardware_concurrency() * 2));
+  };
+  addApiRoutes (svr);
+
+  // Static files, any route name with an extension
+  route (svr, "GET", R"(/([\w\-]+\.\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    std::shared_ptr<const UMLAsset> asset = assets.find (req.matches[1].str());
+    if (!asset)
+    {
+      res.status = 404;
+      return;
+    }
+    res.set_header ("Cache-Control", asset->cacheControl);
+    sendStored (req, res, asset->body, asset->gzipped, asset->etag, asset->type.c_str());
+  });
+
+  route (svr, "GET", "/", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
+    UMLSession& session = *context.session;
+    UMLDocument& document = *context.document;
+    json messages;
+    {
+      std::lock_guard<std::mutex> guard (session.lock);
+      messages["errors"] = session.errors;
+      session.errors.clear();
+      messages["success"] = session.success;
+      session.success.clear();
+      messages["view"] = session.view;
+    }
+    // Pages carrying one-shot messages are rendered once and never cached
+    bool cacheable = messages["errors"].empty() && messages["success"].empty();
+    // Keyed by view alone, so a new save listing replaces the page rather
+    // than adding another
+    std::string key = "index:" + messages["view"].dump();
+    // Names and generation come from one look at the catalog, so a page
+    // is never cached under a generation its listing doesn't match
+    UMLSaveCatalog::Listing saves = UMLSaveCatalog::working().listing();
+    unsigned long generation = saves.generation;
+
+    document.model.read ([&] (const UMLData& data, unsigned long version) {
+      if (cacheable)
+      {
+        auto page = document.pages.find (key, version, generation);
+        if (page)
+        {
+          sendPage (req, res, *page, "text/html");
+          return;
+        }
+      }
+
+      // attributes carry their id, the page's links and forms use it
+      json j = indexedJson (data);
+      j["errors"] = messages["errors"];
+      j["success"] = messages["success"];
+      j["files"] = *saves.names;
+      j["view"] = messages["view"];
+      j["version"] = version;
+      j["document"] = document.name;
+      std::string body = templates.render (INDEX_TEMPLATE, j);
+      if (cacheable)
+        sendPage (req, res, *document.pages.store (key, version, std::move (body), generation), "text/html");
+      else
+        sendContent (req, res, body, "text/html");
+    });
+  });
+
+  route (svr, "GET", "/add/class", [&] (const httplib::Request& req, httplib::Response& res) {
+      Context context = open (req, res);
       std::string name = req.params.find ("cname")->second;
-      ERR_ADD (data.addClass (name));
+      ERR_ADD (data.addClass (name), classDelta (data, name));
       res.set_redirect ("/");
     });
 
-  svr.Get (R"(/add/field/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/add/field/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+      Context context = open (req, res);
       std::string className = req.matches[1].str();
       std::string fieldName = req.params.find ("fname")->second;
       std::string fieldType = req.params.find ("ftype")->second;
       ERR_ADD (data.addClassAttribute (
-        className, std::make_shared<UMLField> (fieldName, fieldType)));
+        className, std::make_shared<UMLField> (fieldName, fieldType)), classDelta (data, className));
       res.set_redirect ("/");
     });
 
-  svr.Get (R"(/add/method/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/add/method/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+      Context context = open (req, res);
       std::string className = req.matches[1].str();
       std::string methodName = req.params.find ("mname")->second;
       std::string methodType = req.params.find ("mtype")->second;
       ERR_ADD (data.addClassAttribute (
-        className, std::make_shared<UMLMethod> (methodName, methodType, std::list<UMLParameter>{})));
+        className, std::make_shared<UMLMethod> (methodName, methodType, std::list<UMLParameter>{})), classDelta (data, className));
       res.set_redirect ("/");
     });
 
-  svr.Get (R"(/add/parameter/(\w+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  // Attributes are looked up by id inside the edit, so another request
+  // moving them doesn't change which one is edited
+  route (svr, "GET", R"(/add/parameter/(\w+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string className = req.matches[1].str();
-    int methodIndex = std::stoi (req.matches[2].str());
+    unsigned long methodId = std::stoul (req.matches[2].str());
     std::string paramName = req.params.find ("pname")->second;
     std::string paramType = req.params.find ("ptype")->second;
 
-    auto attr = data.getClassCopy (className).getAttributes()[methodIndex];
-    ERR_ADD (data.addParameter (className, std::static_pointer_cast<UMLMethod> (attr), paramName, paramType));
+    ERR_ADD (
+      data.addParameter (className, methodAt (data, className, methodId), paramName, paramType),
+      classDelta (data, className));
     res.set_redirect ("/");
   });
-  //delete/parameter/classname/methodindex/paramname
-  svr.Get (R"(/delete/parameter/(\w+)/(\d+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  //delete/parameter/classname/methodid/paramname
+  route (svr, "GET", R"(/delete/parameter/(\w+)/(\d+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string className = req.matches[1].str();
-    int methodIndex = std::stoi (req.matches[2].str());
+    unsigned long methodId = std::stoul (req.matches[2].str());
     std::string paramName = req.matches[3].str();
 
-    auto attr = data.getClassCopy (className).getAttributes()[methodIndex];
-    ERR_ADD (data.deleteParameter (className, std::static_pointer_cast<UMLMethod> (attr), paramName));
+    ERR_ADD (
+      data.deleteParameter (className, methodAt (data, className, methodId), paramName),
+      classDelta (data, className));
     res.set_redirect ("/");
   });
 
-  //edit/parameter/classname/methodINDEX/parametername/
-  svr.Get (R"(/edit/parameter/(\w+)/(\d+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  //edit/parameter/classname/methodid/parametername/
+  route (svr, "GET", R"(/edit/parameter/(\w+)/(\d+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string className = req.matches[1].str();
     
-    int methodIndex = std::stoi (req.matches[2].str());
+    unsigned long methodId = std::stoul (req.matches[2].str());
     std::string oldParamName = req.matches[3].str();
 
     std::string newParamName = req.params.find ("pname")->second;
@@ -121,175 +328,234 @@ void UMLServer::start (int port)
 
     if (oldParamName != newParamName)
     {
-      auto attr = data.getClassCopy (className).getAttributes()[methodIndex];
-      
-      ERR_ADD (data.deleteParameter (className, std::static_pointer_cast<UMLMethod> (attr), oldParamName));
+      ERR_ADD (
+        data.deleteParameter (className, methodAt (data, className, methodId), oldParamName),
+        classDelta (data, className));
 
-      ERR_ADD (data.addParameter (className, std::static_pointer_cast<UMLMethod> (attr), newParamName, newParamType));
+      ERR_ADD (
+        data.addParameter (className, methodAt (data, className, methodId), newParamName, newParamType),
+        classDelta (data, className));
     }
     res.set_redirect ("/");
   });
 
-  svr.Get ("/add/relationship", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", "/add/relationship", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string source = req.params.find ("source")->second;
     std::string dest = req.params.find ("dest")->second;
     std::string type = req.params.find ("reltype")->second;
-    ERR_ADD (data.addRelationship (source, dest, std::stoi (type)));
+    ERR_ADD (data.addRelationship (source, dest, std::stoi (type)), relationshipDelta (data, source, dest));
     res.set_redirect ("/");
   });
 
   //edit/relationship/source/dest
-  svr.Get (R"(/edit/relationship/(\w+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/edit/relationship/(\w+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string source = req.matches[1].str();
     std::string dest = req.matches[2].str();
     std::string type = req.params.find ("reltype")->second;
     ERR_ADD (
-      data.changeRelationshipType (source, dest, std::stoi (type)));
+      data.changeRelationshipType (source, dest, std::stoi (type)),
+      relationshipDelta (data, source, dest));
     res.set_redirect ("/");
   });
 
   //source/dest
-  svr.Get (R"(/delete/relationship/(\w+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/delete/relationship/(\w+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string source = req.matches[1].str();
     std::string dest = req.matches[2].str();
-    ERR_ADD (data.deleteRelationship (source, dest));
+    ERR_ADD (data.deleteRelationship (source, dest), deletedRelationshipDelta (source, dest));
     res.set_redirect ("/");
   });
 
   //class/attribute
-  svr.Get (R"(/delete/attribute/(\w+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/delete/attribute/(\w+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string uclass = req.matches[1].str();  
-    int attrIndex = std::stoi (req.matches[2].str());
+    unsigned long attrId = std::stoul (req.matches[2].str());
 
-    auto attr = data.getClassCopy(uclass).getAttributes()[attrIndex];
-
-    ERR_ADD (data.removeClassAttribute(uclass, attr));
+    ERR_ADD (
+      auto attr = data.getClass (uclass).getAttributeById (attrId);
+      data.removeClassAttribute(uclass, attr),
+      classDelta (data, uclass));
     res.set_redirect ("/");
   });
 
-  svr.Get (R"(/delete/class/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/delete/class/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string uclass = req.matches[1].str();
-    ERR_ADD (data.deleteClass (uclass));
+    pageEdit (context, [&] (UMLData& data) {
+      return deleteClass (data, uclass);
+    });
     res.set_redirect ("/");
   });
 
-  svr.Get (R"(/edit/class/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/edit/class/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string oldClassName = req.matches[1].str();
     std::string newClassName = req.params.find ("cname")->second;
     if (oldClassName != newClassName)
     {
-      ERR_ADD (data.changeClassName (oldClassName, newClassName));
+      pageEdit (context, [&] (UMLData& data) {
+        return renameClass (data, oldClassName, newClassName);
+      });
     }
     res.set_redirect ("/");
   });
 
-  //edit/attribute/classname/(method/field INDEX)
-  svr.Get (R"(/edit/attribute/(\w+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  //edit/attribute/classname/(method/field id)
+  route (svr, "GET", R"(/edit/attribute/(\w+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string className = req.matches[1].str();
-    int attrIndex = std::stoi (req.matches[2].str());
+    unsigned long attrId = std::stoul (req.matches[2].str());
     std::string newName = req.params.find ("name")->second;
     std::string newType = req.params.find ("type")->second;
-    auto attr = data.getClassCopy (className).getAttributes()[attrIndex];
-    if (attr->getAttributeName() != newName)
-    {
-      ERR_ADD (data.changeAttributeType (attr, newType));
-      ERR_ADD (data.changeAttributeName (className, attr, newName));
-    }
+    // Type and name are separate edits, a failed rename keeps the new type
+    pageEdit (context, [&] (UMLData& data) {
+      auto attr = data.getClass (className).getAttributeById (attrId);
+      if (attr->getAttributeName() == newName)
+        return json();
+      data.changeAttributeType (attr, newType);
+      return classDelta (data, className);
+    });
+    pageEdit (context, [&] (UMLData& data) {
+      auto attr = data.getClass (className).getAttributeById (attrId);
+      if (attr->getAttributeName() == newName)
+        return json();
+      data.changeAttributeName (className, attr, newName);
+      return classDelta (data, className);
+    });
     res.set_redirect ("/");
   });
 
-  svr.Get ("/index", [&] (const httplib::Request& req, httplib::Response& res) {
-    inja::Environment env;
-    inja::Template temp = env.parse_template ("../templates/index.html");
-    json j = data.getJson();
-    j["errors"] = errors;
-    errors.clear();
-    res.set_content (env.render (temp, j), "text/html");
+  route (svr, "GET", "/index", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
+    json j = context.document->model.read ([] (const UMLData& data, unsigned long version) {
+      return data.getJson();
+    });
+    {
+      std::lock_guard<std::mutex> guard (context.session->lock);
+      j["errors"] = context.session->errors;
+      context.session->errors.clear();
+    }
+    sendContent (req, res, templates.render (INDEX_TEMPLATE, j), "text/html");
   });
 
-  svr.Get ("/help", [&] (const httplib::Request& req, httplib::Response& res) {
-    inja::Environment env;
-    inja::Template temp = env.parse_template ("../helpGUI.html");
-    json j = data.getJson();
-    j["errors"] = errors;
-    errors.clear();
-    res.set_content (env.render (temp, j), "text/html");
+  route (svr, "GET", "/help", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
+    json j = context.document->model.read ([] (const UMLData& data, unsigned long version) {
+      return data.getJson();
+    });
+    {
+      std::lock_guard<std::mutex> guard (context.session->lock);
+      j["errors"] = context.session->errors;
+      context.session->errors.clear();
+    }
+    sendContent (req, res, templates.render (HELP_TEMPLATE, j), "text/html");
   });
 
-  svr.Get ("/save", [&] (const httplib::Request& req, httplib::Response& res) {
-    success += "File Saved!";
+  route (svr, "GET", "/save", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
+    {
+      std::lock_guard<std::mutex> guard (context.session->lock);
+      context.session->success += "File Saved!";
+    }
     res.set_redirect ("/");
   });
 
   //sends json file over as text 
-  svr.Get ("/save/data", [&] (const httplib::Request& req, httplib::Response& res) {
-    res.set_content(data.getJson().dump(), "text/plain");
+  route (svr, "GET", "/save/data", [&] (const httplib::Request& req, httplib::Response& res) {
+    std::shared_ptr<UMLDocument> document = documentFor (req);
+    auto page = document->model.read ([&] (const UMLData& data, unsigned long version) {
+      auto page = document->pages.find ("data", version);
+      if (!page)
+        page = document->pages.store ("data", version, data.getJson().dump());
+      return page;
+    });
+    sendPage (req, res, *page, "text/plain");
   });
 
-  svr.Post ("/load", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "POST", "/load", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     //getting load file content 
     std::string fileLoad = req.get_file_value("load").content;
     ERR_ADD(
       //convert file to json
       json fileLoadJson = json::parse(fileLoad);
       //update data object
-      data = load_json(fileLoadJson);
+      data = load_json(fileLoadJson),
+      fullDelta (data)
     );
-    success += "File Loaded!";
+    {
+      std::lock_guard<std::mutex> guard (context.session->lock);
+      context.session->success += "File Loaded!";
+    }
     res.set_redirect ("/");
   });
 
-  svr.Get ("/undo", [&] (const httplib::Request& req, httplib::Response& res) {
-    data = history.undo();
+  route (svr, "GET", "/undo", [&] (const httplib::Request& req, httplib::Response& res) {
+    open (req, res).document->model.undo (fullDelta);
     res.set_redirect ("/");
   });
 
-  svr.Get ("/redo", [&] (const httplib::Request& req, httplib::Response& res) {
-    data = history.redo();
+  route (svr, "GET", "/redo", [&] (const httplib::Request& req, httplib::Response& res) {
+    open (req, res).document->model.redo (fullDelta);
     res.set_redirect ("/");
   });
 
   // position/className/x/y
-  svr.Get (R"(/position/(\w+)/(\d+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+  route (svr, "GET", R"(/position/(\w+)/(\d+)/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    Context context = open (req, res);
     std::string className = req.matches[1].str();
     
     int x = std::stoi (req.matches[2].str());
     int y = std::stoi (req.matches[3].str());
   
-    data.getClass (className).setX (x);
-    data.getClass (className).setY (y);
-    history.save (data);
+    ERR_ADD (
+      data.getClass (className).setX (x);
+      data.getClass (className).setY (y),
+      classDelta (data, className)
+    );
     res.set_redirect ("/");
   });
 
   // changes view to specific class
-  svr.Get(R"(/change/view/class/(\w+))", [&](const httplib::Request &req, httplib::Response &res) {
+  route (svr, "GET", R"(/change/view/class/(\w+))", [&](const httplib::Request &req, httplib::Response &res) {
     std::string objectName = req.matches[1].str();
-    view["object"] = "class";
-    view["name"] = objectName;
+    UMLSession& session = *open (req, res).session;
+    std::lock_guard<std::mutex> guard (session.lock);
+    session.view["object"] = "class";
+    session.view["name"] = objectName;
     res.set_redirect ("/");
   });
 
   // changes view to specific relationship
-  svr.Get(R"(/change/view/relationship/(\w+)/(\w+))", [&](const httplib::Request &req, httplib::Response &res) {
+  route (svr, "GET", R"(/change/view/relationship/(\w+)/(\w+))", [&](const httplib::Request &req, httplib::Response &res) {
     std::string dest = req.matches[1].str();
     std::string src = req.matches[2].str();
-    view["object"] = "relationship";
-    view["name"] = dest;
-    view["name2"] = src;
+    UMLSession& session = *open (req, res).session;
+    std::lock_guard<std::mutex> guard (session.lock);
+    session.view["object"] = "relationship";
+    session.view["name"] = dest;
+    session.view["name2"] = src;
     res.set_redirect ("/");
   });
   
   //changes view to other types
-  svr.Get(R"(/change/view/(\w+))", [&](const httplib::Request &req, httplib::Response &res) {
+  route (svr, "GET", R"(/change/view/(\w+))", [&](const httplib::Request &req, httplib::Response &res) {
     std::string object = req.matches[1].str();
-    view["object"] = object;
+    UMLSession& session = *open (req, res).session;
+    std::lock_guard<std::mutex> guard (session.lock);
+    session.view["object"] = object;
     res.set_redirect ("/");
   });
 
   //dispalays the main 'all' view
-  svr.Get(R"(/change/view/all)", [&](const httplib::Request &req, httplib::Response &res) {
-    view["object"] = "all";
+  route (svr, "GET", R"(/change/view/all)", [&](const httplib::Request &req, httplib::Response &res) {
+    UMLSession& session = *open (req, res).session;
+    std::lock_guard<std::mutex> guard (session.lock);
+    session.view["object"] = "all";
     res.set_redirect ("/");
   });
 
@@ -297,69 +563,612 @@ void UMLServer::start (int port)
   svr.listen ("localhost", port);
 }
 
+// Registers a handler whose requests are counted and timed under its
+// pattern, and traced under its method and pattern. The metrics are looked
+// up once here, not per request.
+void UMLServer::route (httplib::Server& svr, const std::string& method, const std::string& pattern, Handler handler)
+{
+  std::string labels = "method=" + UMLMetrics::label (method) + ",route=" + UMLMetrics::label (pattern);
+  UMLHistogram& latency = UMLMetrics::global().histogram ("uml_http_request_duration_seconds",
+    "Time taken to handle requests, by route", labels);
+  UMLCounter& errors = UMLMetrics::global().counter ("uml_http_request_errors_total",
+    "Requests answered with an error status, by route", labels);
 
+  // Trace spans keep a pointer to their name, so the handler owns it
+  auto name = std::make_shared<const std::string> (method + " " + pattern);
+  Handler timed = [&latency, &errors, name, handler] (const httplib::Request& req, httplib::Response& res) {
+    UML_TRACE_SCOPE (name->c_str());
+    UMLTimer timer (latency);
+    try
+    {
+      handler (req, res);
+    }
+    catch (...)
+    {
+      errors.add();
+      throw;
+    }
+    if (res.status >= 400)
+      errors.add();
+  };
 
-// Attribute index management
-void UMLServer::addAttributeIndexes (json& j, const UMLData& data)
+  if (method == "GET")
+    svr.Get (pattern, timed);
+  else if (method == "POST")
+    svr.Post (pattern, timed);
+  else if (method == "PATCH")
+    svr.Patch (pattern, timed);
+  else if (method == "DELETE")
+    svr.Delete (pattern, timed);
+  else
+    throw std::runtime_error ("Unsupported method " + method);
+}
+
+// Writes the registry's metrics, then figures read from the documents
+// themselves, in Prometheus' text format
+std::string UMLServer::metricsText ()
+{
+  std::string text = UMLMetrics::global().exposition();
+
+  json figures = store.metrics();
+  text += "# TYPE uml_documents_resident gauge\n";
+  text += UMLMetrics::sample ("uml_documents_resident", "", figures["resident_documents"]);
+  text += "# TYPE uml_documents_resident_bytes gauge\n";
+  text += UMLMetrics::sample ("uml_documents_resident_bytes", "", figures["resident_bytes"]);
+  text += "# TYPE uml_document_evictions_total counter\n";
+  text += UMLMetrics::sample ("uml_document_evictions_total", "", figures["evictions"]);
+  text += "# TYPE uml_document_rehydrations_total counter\n";
+  text += UMLMetrics::sample ("uml_document_rehydrations_total", "", figures["rehydrations"]);
+
+  // Sizes of each resident document, from its latest snapshot
+  std::string classes = "# TYPE uml_model_classes gauge\n";
+  std::string attributes = "# TYPE uml_model_attributes gauge\n";
+  std::string relationships = "# TYPE uml_model_relationships gauge\n";
+  std::string undos = "# TYPE uml_history_undo_depth gauge\n";
+  for (const std::shared_ptr<UMLDocument>& document : store.residentDocuments())
+  {
+    std::string labels = "document=" + UMLMetrics::label (document->name);
+    document->model.read ([&] (const UMLData& data, unsigned long version) {
+      size_t attributeCount = 0;
+      for (const UMLClass& uclass : data.getClasses())
+        attributeCount += uclass.getAttributes().size();
+      classes += UMLMetrics::sample ("uml_model_classes", labels, data.getClasses().size());
+      attributes += UMLMetrics::sample ("uml_model_attributes", labels, attributeCount);
+      relationships += UMLMetrics::sample ("uml_model_relationships", labels, data.getRelationships().size());
+      return 0;
+    });
+    undos += UMLMetrics::sample ("uml_history_undo_depth", labels, document->model.undoDepth());
+  }
+  return text + classes + attributes + relationships + undos;
+}
+
+// Reads a cookie sent with the request, or "" if it wasn't sent
+static std::string cookieValue (const httplib::Request& req, const std::string& name)
 {
-  for (auto uclass : data.getClasses())
+  std::string cookies = req.get_header_value ("Cookie");
+  size_t start = 0;
+  while (start < cookies.size())
   {
-    int index = 0;
-    //assign vector element id for each attribute
-    for (auto attr : uclass.getAttributes())
+    size_t end = cookies.find (';', start);
+    if (end == std::string::npos)
+      end = cookies.size();
+    size_t first = cookies.find_first_not_of (' ', start);
+    size_t equals = cookies.find ('=', first);
+    if (equals < end && cookies.compare (first, equals - first, name) == 0)
+      return cookies.substr (equals + 1, end - equals - 1);
+    start = end + 1;
+  }
+  return "";
+}
+
+// Finds the document a request names with ?doc=, or its cookie
+std::shared_ptr<UMLDocument> UMLServer::documentFor (const httplib::Request& req)
+{
+  std::string name = req.get_param_value ("doc");
+  if (!UMLDocumentStore::isValidName (name))
+    name = cookieValue (req, DOCUMENT_COOKIE);
+  if (!UMLDocumentStore::isValidName (name))
+    name = UMLDocumentStore::DEFAULT_DOCUMENT;
+  return store.document (name);
+}
+
+// Finds the document and session of a page request. A document picked with
+// ?doc= is remembered so the forms and redirects that follow stay on it.
+UMLServer::Context UMLServer::open (const httplib::Request& req, httplib::Response& res)
+{
+  Context context;
+  context.document = documentFor (req);
+  if (req.has_param ("doc") && cookieValue (req, DOCUMENT_COOKIE) != context.document->name)
+    res.set_header ("Set-Cookie", DOCUMENT_COOKIE + "=" + context.document->name + "; Path=/; SameSite=Lax");
+
+  std::string id = cookieValue (req, SESSION_COOKIE);
+  if (id.size() != 32 || !UMLDocumentStore::isValidName (id))
+  {
+    id = UMLDocumentStore::newSessionId();
+    res.set_header ("Set-Cookie", SESSION_COOKIE + "=" + id + "; Path=/; HttpOnly; SameSite=Lax");
+  }
+  context.session = store.session (id);
+  return context;
+}
+
+// Runs a page route edit, recording its error for the next render
+void UMLServer::pageEdit (Context& context, const UMLSharedModel::Edit& edit)
+{
+  try
+  {
+    context.document->model.write (edit);
+  }
+  catch (const std::exception& error)
+  {
+    std::lock_guard<std::mutex> guard (context.session->lock);
+    context.session->errors += error.what();
+  }
+}
+
+// Reads a relationship type given either by name or by number
+static int relationshipType (const json& type)
+{
+  if (type.is_string())
+    return UMLRelationship::string_to_type (type.get<std::string>());
+  return type.get<int>();
+}
+
+// Operations accepted by /api/v1/batch, keyed by their "op" name. Each takes
+// the same fields as the matching single-edit API route.
+static const std::map<std::string, std::function<void (UMLData&, const json&)>> BATCH_OPERATIONS = {
+  {"add_class", [] (UMLData& data, const json& op) {
+    data.addClass (op.at ("name"));
+  }},
+  {"rename_class", [] (UMLData& data, const json& op) {
+    data.changeClassName (op.at ("class"), op.at ("name"));
+  }},
+  {"move_class", [] (UMLData& data, const json& op) {
+    UMLClass& uclass = data.getClass (op.at ("class"));
+    uclass.setX (op.at ("position_x"));
+    uclass.setY (op.at ("position_y"));
+  }},
+  {"delete_class", [] (UMLData& data, const json& op) {
+    data.deleteClass (op.at ("class"));
+  }},
+  {"add_field", [] (UMLData& data, const json& op) {
+    data.addClassAttribute (op.at ("class"), std::make_shared<UMLField> (op.at ("name"), op.at ("type")));
+  }},
+  {"add_method", [] (UMLData& data, const json& op) {
+    std::list<UMLParameter> params;
+    for (const json& param : op.value ("params", json::array()))
+      params.push_back (UMLParameter (param.at ("name"), param.at ("type")));
+    data.addClassAttribute (op.at ("class"), std::make_shared<UMLMethod> (op.at ("name"), op.at ("return_type"), params));
+  }},
+  {"edit_attribute", [] (UMLData& data, const json& op) {
+    std::string className = op.at ("class");
+    attr_ptr attr = attributeAt (data, className, op.at ("id"));
+    if (op.contains ("type"))
+      data.changeAttributeType (attr, op["type"]);
+    if (op.contains ("name") && op["name"] != attr->getAttributeName())
+      data.changeAttributeName (className, attr, op["name"]);
+  }},
+  {"delete_attribute", [] (UMLData& data, const json& op) {
+    std::string className = op.at ("class");
+    data.removeClassAttribute (className, attributeAt (data, className, op.at ("id")));
+  }},
+  {"add_parameter", [] (UMLData& data, const json& op) {
+    std::string className = op.at ("class");
+    data.addParameter (className, methodAt (data, className, op.at ("method")), op.at ("name"), op.at ("type"));
+  }},
+  {"delete_parameter", [] (UMLData& data, const json& op) {
+    std::string className = op.at ("class");
+    data.deleteParameter (className, methodAt (data, className, op.at ("method")), op.at ("name"));
+  }},
+  {"add_relationship", [] (UMLData& data, const json& op) {
+    data.addRelationship (op.at ("source"), op.at ("destination"), relationshipType (op.at ("type")));
+  }},
+  {"change_relationship", [] (UMLData& data, const json& op) {
+    data.changeRelationshipType (op.at ("source"), op.at ("destination"), relationshipType (op.at ("type")));
+  }},
+  {"delete_relationship", [] (UMLData& data, const json& op) {
+    data.deleteRelationship (op.at ("source"), op.at ("destination"));
+  }},
+};
+
+// Applies a list of operations as one unit. Stops at the first failure and
+// puts data back the way it was. Returns whether every operation applied, and
+// a result for each: "ok", the failure's "error", or "skipped" after it.
+json UMLServer::applyBatch (UMLData& data, const json& operations)
+{
+  if (!operations.is_array())
+    throw std::runtime_error ("Batch must be an array of operations");
+
+  // Operations change data in place, so keep what to go back to. A clone
+  // keeps attribute ids, which a reload from json would not.
+  UMLData before = data.clone();
+  json results = json::array();
+  size_t applied = 0;
+  try
+  {
+    for (const json& op : operations)
+    {
+      auto operation = BATCH_OPERATIONS.find (op.at ("op").get<std::string>());
+      if (operation == BATCH_OPERATIONS.end())
+        throw std::runtime_error ("Unknown operation " + op["op"].dump());
+      operation->second (data, op);
+      results += {{"ok", true}};
+      ++applied;
+    }
+  }
+  catch (const std::exception& error)
+  {
+    data = std::move (before);
+    results += {{"ok", false}, {"error", error.what()}};
+    for (size_t i = applied + 1; i < operations.size(); ++i)
+      results += {{"ok", false}, {"skipped", true}};
+    return {{"ok", false}, {"failed", applied}, {"results", results}};
+  }
+  return {{"ok", true}, {"results", results}};
+}
+
+// JSON API routes that answer with changed entities. Every response holds the
+// new model version plus only what changed:
+//   { "version": 7, "classes": [...], "relationships": [...],
+//     "deleted": { "classes": [...], "relationships": [...] } }
+void UMLServer::addApiRoutes (httplib::Server& svr)
+{
+  // Applies an edit, then answers with the entities it returned and the new version
+  auto apply = [&] (const httplib::Request& req, httplib::Response& res, const UMLSharedModel::Edit& edit) {
+    std::shared_ptr<UMLDocument> document = documentFor (req);
+    try
+    {
+      json delta = document->model.write (edit);
+      sendContent (req, res, delta.dump(), "application/json");
+    }
+    catch (const std::exception& error)
+    {
+      res.status = 400;
+      res.set_content (json {{"error", error.what()}, {"version", document->model.version()}}.dump(), "application/json");
+    }
+  };
+
+  route (svr, "GET", "/api/v1/model", [&] (const httplib::Request& req, httplib::Response& res) {
+    json delta = documentFor (req)->model.read ([] (const UMLData& data, unsigned long version) {
+      json delta = fullDelta (data);
+      delta["version"] = version;
+      return delta;
+    });
+    sendContent (req, res, delta.dump(), "application/json");
+  });
+
+  // Every document, plus how many are in memory and how eviction is going
+  route (svr, "GET", "/api/v1/documents", [&] (const httplib::Request& req, httplib::Response& res) {
+    json j = store.metrics();
+    j["documents"] = store.listDocuments();
+    sendContent (req, res, j.dump(), "application/json");
+  });
+
+  // Request timings and model sizes for Prometheus to scrape
+  route (svr, "GET", "/metrics", [&] (const httplib::Request& req, httplib::Response& res) {
+    sendContent (req, res, metricsText(), "text/plain; version=0.0.4");
+  });
+
+  // Memory the document's model and history take up, and where it goes.
+  // Both are counted as they change, so this is cheap on any model.
+  route (svr, "GET", "/stats", [&] (const httplib::Request& req, httplib::Response& res) {
+    std::shared_ptr<UMLDocument> document = documentFor (req);
+    json stats = document->model.read ([] (const UMLData& data, unsigned long version) {
+      json stats;
+      stats["version"] = version;
+      stats["model"] = data.getFootprint().toJson();
+      return stats;
+    });
+    stats["document"] = document->name;
+    stats["history"] = {
+      {"undos", document->model.undoDepth()},
+      {"bytes", document->model.historyFootprint()}
+    };
+    sendContent (req, res, stats.dump(), "application/json");
+  });
+
+  // Spans recorded by a UML_TRACING build, as Chrome trace_event JSON
+  route (svr, "GET", "/debug/trace", [&] (const httplib::Request& req, httplib::Response& res) {
+    sendContent (req, res, UMLTrace::global().dump().dump(), "application/json");
+  });
+
+  // Server-sent event stream of changes. Starts after ?since=<version>, or
+  // the Last-Event-ID the browser sends when it reconnects on its own.
+  route (svr, "GET", "/api/v1/events", [&] (const httplib::Request& req, httplib::Response& res) {
+    std::shared_ptr<UMLDocument> document = documentFor (req);
+    unsigned long since = document->model.version();
+    try
+    {
+      // A reconnecting browser repeats the original URL, so its header wins
+      if (req.has_header ("Last-Event-ID"))
+        since = std::stoul (req.get_header_value ("Last-Event-ID"));
+      else if (req.has_param ("since"))
+        since = std::stoul (req.get_param_value ("since"));
+    }
+    catch (const std::exception& error)
     {
-      //for field, match the name
-      if (attr->identifier() == "field")
+      // Malformed versions start from the current one
+    }
+
+    auto sent = std::make_shared<unsigned long> (since);
+    res.set_header ("Cache-Control", "no-cache");
+    res.set_chunked_content_provider ("text/event-stream", [document, sent] (size_t offset, httplib::DataSink& sink) {
+      std::vector<UMLChangeFeed::Event> events;
+      std::string chunk;
+      if (!document->feed.waitSince (*sent, std::chrono::seconds (15), events))
       {
-        for (int classID = 0; classID < j["classes"].size(); ++classID)
-        {
-          for (int fieldID = 0; fieldID < j["classes"][classID]["fields"].size(); ++fieldID)
-          {
-            if (j["classes"][classID]["fields"][fieldID]["name"] == attr->getAttributeName())
-            {
-              j["classes"][classID]["fields"][fieldID]["index"] = index;
-            }
-          }
-        }
+        // Too far behind to replay, the client reloads the whole model
+        *sent = document->feed.latest();
+        chunk = "id: " + std::to_string (*sent) + "\nevent: reset\ndata: {}\n\n";
+      }
+      else if (events.empty())
+      {
+        // Comment line keeps proxies from closing an idle stream
+        chunk = ": keepalive\n\n";
       }
-      else if (attr->identifier() == "method") //for method, match  name and parameters
+      for (const UMLChangeFeed::Event& event : events)
       {
+        chunk += "id: " + std::to_string (event.version) + "\nevent: delta\ndata: " + event.payload + "\n\n";
+        *sent = event.version;
+      }
+      sink.write (chunk.data(), chunk.size());
+      return true;
+    });
+  });
 
-        for (int classID = 0; classID < j["classes"].size(); ++classID)
-        {
-          for (int methodID = 0; methodID < j["classes"][classID]["methods"].size(); ++methodID)
-          {
-            //check params match as methods have same name
-            if (j["classes"][classID]["methods"][methodID]["name"] == attr->getAttributeName())
-            {
-              std::list<UMLParameter> params = std::dynamic_pointer_cast<UMLMethod> (attr)->getParam();
-              bool containsParameter = false;
-              for (auto param : params)
-              {
-                for (int k = 0; k < j["classes"][classID]["methods"][methodID]["params"].size(); ++k)
-                {
-                  if (param.getType() == j["classes"][classID]["methods"][methodID]["params"][k]["type"])
-                  {
-                    containsParameter = true;
-                  }
-                }
-                if (!containsParameter)
-                {
-                  break;
-                }
-              }
-
-              if (containsParameter || (params.size() == 0 && j["classes"][classID]["methods"][methodID]["params"].size() == 0))
-              {
-                j["classes"][classID]["methods"][methodID]["index"] = index;
-              }
-            }
-          }
-        }
+  // Classes
+
+  route (svr, "POST", "/api/v1/classes", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string name = json::parse (req.body).at ("name");
+      data.addClass (name);
+      return classDelta (data, name);
+    });
+  });
+
+  // Renames and/or moves a class
+  route (svr, "PATCH", R"(/api/v1/classes/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      json body = json::parse (req.body);
+      json delta;
+      if (body.contains ("name") && body["name"] != className)
+      {
+        std::string newName = body["name"];
+        delta = renameClass (data, className, newName);
+        className = newName;
+      }
+      if (body.contains ("position_x"))
+        data.getClass (className).setX (body["position_x"]);
+      if (body.contains ("position_y"))
+        data.getClass (className).setY (body["position_y"]);
+      delta["classes"] = json::array ({classJson (data.getClass (className))});
+      return delta;
+    });
+  });
+
+  route (svr, "DELETE", R"(/api/v1/classes/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      return deleteClass (data, req.matches[1].str());
+    });
+  });
+
+  // Attributes
+
+  route (svr, "POST", R"(/api/v1/classes/(\w+)/fields)", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      json body = json::parse (req.body);
+      data.addClassAttribute (className, std::make_shared<UMLField> (body.at ("name"), body.at ("type")));
+      return classDelta (data, className);
+    });
+  });
+
+  route (svr, "POST", R"(/api/v1/classes/(\w+)/methods)", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      json body = json::parse (req.body);
+      std::list<UMLParameter> params;
+      for (const json& param : body.value ("params", json::array()))
+        params.push_back (UMLParameter (param.at ("name"), param.at ("type")));
+      data.addClassAttribute (className, std::make_shared<UMLMethod> (body.at ("name"), body.at ("return_type"), params));
+      return classDelta (data, className);
+    });
+  });
+
+  // Renames and/or retypes a field or method
+  route (svr, "PATCH", R"(/api/v1/classes/(\w+)/attributes/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      attr_ptr attr = attributeAt (data, className, std::stoul (req.matches[2].str()));
+      json body = json::parse (req.body);
+      if (body.contains ("type"))
+        data.changeAttributeType (attr, body["type"]);
+      if (body.contains ("name") && body["name"] != attr->getAttributeName())
+        data.changeAttributeName (className, attr, body["name"]);
+      return classDelta (data, className);
+    });
+  });
+
+  route (svr, "DELETE", R"(/api/v1/classes/(\w+)/attributes/(\d+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      attr_ptr attr = attributeAt (data, className, std::stoul (req.matches[2].str()));
+      data.removeClassAttribute (className, attr);
+      return classDelta (data, className);
+    });
+  });
+
+  // Parameters
+
+  route (svr, "POST", R"(/api/v1/classes/(\w+)/methods/(\d+)/params)", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      method_ptr method = methodAt (data, className, std::stoul (req.matches[2].str()));
+      json body = json::parse (req.body);
+      data.addParameter (className, method, body.at ("name"), body.at ("type"));
+      return classDelta (data, className);
+    });
+  });
+
+  // Renames and/or retypes a parameter
+  route (svr, "PATCH", R"(/api/v1/classes/(\w+)/methods/(\d+)/params/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      method_ptr method = methodAt (data, className, std::stoul (req.matches[2].str()));
+      std::string paramName = req.matches[3].str();
+      json body = json::parse (req.body);
+      if (body.contains ("type"))
+        data.changeParameterType (className, method, paramName, body["type"]);
+      if (body.contains ("name") && body["name"] != paramName)
+        data.changeParameterName (method, paramName, body["name"]);
+      return classDelta (data, className);
+    });
+  });
+
+  route (svr, "DELETE", R"(/api/v1/classes/(\w+)/methods/(\d+)/params/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string className = req.matches[1].str();
+      method_ptr method = methodAt (data, className, std::stoul (req.matches[2].str()));
+      data.deleteParameter (className, method, req.matches[3].str());
+      return classDelta (data, className);
+    });
+  });
+
+  // Relationships
+
+  route (svr, "POST", "/api/v1/relationships", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      json body = json::parse (req.body);
+      std::string source = body.at ("source");
+      std::string destination = body.at ("destination");
+      data.addRelationship (source, destination, relationshipType (body.at ("type")));
+      return relationshipDelta (data, source, destination);
+    });
+  });
+
+  route (svr, "PATCH", R"(/api/v1/relationships/(\w+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string source = req.matches[1].str();
+      std::string destination = req.matches[2].str();
+      data.changeRelationshipType (source, destination, relationshipType (json::parse (req.body).at ("type")));
+      return relationshipDelta (data, source, destination);
+    });
+  });
+
+  route (svr, "DELETE", R"(/api/v1/relationships/(\w+)/(\w+))", [&] (const httplib::Request& req, httplib::Response& res) {
+    apply (req, res, [&] (UMLData& data) {
+      std::string source = req.matches[1].str();
+      std::string destination = req.matches[2].str();
+      data.deleteRelationship (source, destination);
+      return deletedRelationshipDelta (source, destination);
+    });
+  });
+
+  // Applies many operations as one edit with a single history entry. The body
+  // is a json array, or the same array as MessagePack. Replies with the whole
+  // model plus a result per operation; if one fails nothing is applied.
+  route (svr, "POST", "/api/v1/batch", [&] (const httplib::Request& req, httplib::Response& res) {
+    std::shared_ptr<UMLDocument> document = documentFor (req);
+    json operations;
+    try
+    {
+      if (req.get_header_value ("Content-Type") == "application/msgpack")
+        operations = json::from_msgpack (req.body);
+      else
+        operations = json::parse (req.body);
+      if (!operations.is_array())
+        throw std::runtime_error ("Batch must be an array of operations");
+    }
+    catch (const std::exception& error)
+    {
+      res.status = 400;
+      res.set_content (json {{"error", error.what()}, {"version", document->model.version()}}.dump(), "application/json");
+      return;
+    }
+
+    json outcome;
+    json delta = document->model.write ([&] (UMLData& data) {
+      outcome = applyBatch (data, operations);
+      return outcome["ok"] ? fullDelta (data) : json();
+    });
+    if (!outcome["ok"])
+    {
+      res.status = 400;
+      outcome["version"] = document->model.version();
+      sendContent (req, res, outcome.dump(), "application/json");
+      return;
+    }
+    delta["results"] = std::move (outcome["results"]);
+    sendContent (req, res, delta.dump(), "application/json");
+  });
+
+  // History, either may change anything so the whole model is sent back
+
+  route (svr, "POST", "/api/v1/undo", [&] (const httplib::Request& req, httplib::Response& res) {
+    sendContent (req, res, documentFor (req)->model.undo (fullDelta).dump(), "application/json");
+  });
+
+  route (svr, "POST", "/api/v1/redo", [&] (const httplib::Request& req, httplib::Response& res) {
+    sendContent (req, res, documentFor (req)->model.redo (fullDelta).dump(), "application/json");
+  });
+}
+
+// Delta holding the whole model, used when everything may have changed
+json UMLServer::fullDelta (const UMLData& data)
+{
+  json delta = indexedJson (data);
+  delta["full"] = true;
+  return delta;
+}
+
+// Serializes the model like UMLData::getJson, with each attribute's id
+// added as it is written. One pass over the model, the template and
+// page routes refer to attributes by these ids.
+json UMLServer::indexedJson (const UMLData& data)
+{
+  json j;
+  j["classes"] = json::array();
+  for (const UMLClass& uclass : data.getClasses())
+    j["classes"] += classJson (uclass);
+  j["relationships"] = json::array();
+  for (const UMLRelationship& relationship : data.getRelationships())
+    j["relationships"] += relationshipJson (relationship);
+  return j;
+}
+
+// Serializes a class for the API. Matches the class objects in
+// UMLData::getJson, with each attribute's id added.
+json UMLServer::classJson (const UMLClass& uclass)
+{
+  json fields = json::array();
+  json methods = json::array();
+  for (auto attr : uclass.getAttributes())
+  {
+    if (attr->identifier() == "field")
+    {
+      fields += {{"name", attr->getAttributeName()}, {"type", attr->getType()}, {"id", attr->getId()}};
+    }
+    else
+    {
+      json params = json::array();
+      for (auto param : std::static_pointer_cast<UMLMethod> (attr)->getParam())
+      {
+        params += {{"name", param.getName()}, {"type", param.getType()}};
       }
-      ++index;
+      methods += {{"name", attr->getAttributeName()}, {"return_type", attr->getType()}, {"params", params}, {"id", attr->getId()}};
     }
   }
+  return {{"name", uclass.getName()}, {"position_x", uclass.getX()}, {"position_y", uclass.getY()}, {"fields", fields}, {"methods", methods}};
+}
+
+// Serializes a relationship for the API
+json UMLServer::relationshipJson (const UMLRelationship& relationship)
+{
+  return {
+    {"source", relationship.getSource().getName()},
+    {"destination", relationship.getDestination().getName()},
+    {"type", UMLRelationship::type_to_string (relationship.getType())}
+  };
 }
 
 UMLData UMLServer::load_json(json j)
@@ -0,0 +1,207 @@
+/*
+  Filename   : UMLSharedModel.cpp
+  Description: Implementation of the single-writer shared model.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLSharedModel.hpp"
+#include "include/UMLMetrics.hpp"
+//--------------------------------------------------------------------
+
+// Constructor: starts the writer, listener is told about every commit
+UMLSharedModel::UMLSharedModel (Listener newListener, const json& state)
+: listener (std::move (newListener))
+{
+  if (!state.is_null())
+  {
+    history.setJson (state.at ("history"));
+    data = history.load_current();
+    modelVersion = state.at ("version");
+  }
+  publish();
+  writer = std::thread (&UMLSharedModel::writeLoop, this);
+}
+
+// Destructor: finishes queued commands and stops the writer
+UMLSharedModel::~UMLSharedModel ()
+{
+  stop();
+}
+
+// Stops the writer and returns the version and history
+json UMLSharedModel::close ()
+{
+  stop();
+  // The writer has exited, so its state is safe to read here
+  json state;
+  state["version"] = modelVersion;
+  state["history"] = history.getJson();
+  return state;
+}
+
+// Returns roughly how many bytes the model and its history take up
+size_t UMLSharedModel::footprint () const
+{
+  return bytes;
+}
+
+// Returns how many steps can be undone
+size_t UMLSharedModel::undoDepth () const
+{
+  return undos;
+}
+
+// Returns roughly how many bytes the history's snapshots take up
+size_t UMLSharedModel::historyFootprint () const
+{
+  return historyBytes;
+}
+
+// Finishes queued commands and joins the writer
+void UMLSharedModel::stop ()
+{
+  {
+    std::lock_guard<std::mutex> guard (queueLock);
+    stopping = true;
+  }
+  queued.notify_one();
+  if (writer.joinable())
+    writer.join();
+}
+
+// Queues edit for the writer and waits for it to be committed
+json UMLSharedModel::write (const Edit& edit)
+{
+  return submit ([&edit] (UMLData& data, UMLDataHistory& history) {
+    return edit (data);
+  });
+}
+
+// Steps back through history, describe builds the delta of the result.
+// Returns null, and commits nothing, if there is nothing to undo.
+json UMLSharedModel::undo (const Edit& describe)
+{
+  return submit ([&describe] (UMLData& data, UMLDataHistory& history) {
+    if (history.is_undo_empty())
+      return json();
+    data = history.undo();
+    return describe (data);
+  }, false);
+}
+
+// Steps forward through history, describe builds the delta of the result.
+// Returns null, and commits nothing, if there is nothing to redo.
+json UMLSharedModel::redo (const Edit& describe)
+{
+  return submit ([&describe] (UMLData& data, UMLDataHistory& history) {
+    if (history.is_redo_empty())
+      return json();
+    data = history.redo();
+    return describe (data);
+  }, false);
+}
+
+// Returns the version of the latest snapshot
+unsigned long UMLSharedModel::version () const
+{
+  return std::atomic_load (&current)->version;
+}
+
+// Queues a command and waits for the writer to finish it. A recorded
+// command's result is saved into the history once it commits.
+json UMLSharedModel::submit (std::function<json (UMLData&, UMLDataHistory&)> run, bool recorded)
+{
+  auto command = std::make_unique<Command>();
+  command->run = std::move (run);
+  command->recorded = recorded;
+  std::future<json> done = command->done.get_future();
+  {
+    std::lock_guard<std::mutex> guard (queueLock);
+    if (stopping)
+      throw std::runtime_error ("Document is closed");
+    queue.push_back (std::move (command));
+  }
+  queued.notify_one();
+  return done.get();
+}
+
+// Writer loop. Everything queued while the last batch ran is applied as
+// one batch: each command still gets its own history entry and version,
+// but the model is copied into a snapshot once per batch. A command that
+// throws is rolled back from the history. Callers are released only after
+// the snapshot holding their change is published.
+void UMLSharedModel::writeLoop ()
+{
+  std::vector<std::unique_ptr<Command>> batch;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> guard (queueLock);
+      queued.wait (guard, [this] { return stopping || !queue.empty(); });
+      if (queue.empty())
+        return;
+      batch.swap (queue);
+    }
+
+    std::vector<json> results (batch.size());
+    std::vector<std::exception_ptr> failures (batch.size());
+    bool changed = false;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      try
+      {
+        results[i] = batch[i]->run (data, history);
+        // Nothing changed, so there is nothing to record
+        if (results[i].is_null())
+          continue;
+        // Undo and redo have already moved the history onto data
+        if (batch[i]->recorded)
+          history.save (data);
+        results[i]["version"] = ++modelVersion;
+        changed = true;
+      }
+      catch (...)
+      {
+        // The command may have got partway, go back to the last commit so
+        // the next one doesn't save its half-made change
+        failures[i] = std::current_exception();
+        data = history.load_current();
+      }
+    }
+
+    if (changed)
+      publish();
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      if (failures[i])
+      {
+        batch[i]->done.set_exception (failures[i]);
+        continue;
+      }
+      if (listener && !results[i].is_null())
+        listener (results[i]["version"], results[i]);
+      batch[i]->done.set_value (std::move (results[i]));
+    }
+    batch.clear();
+  }
+}
+
+// Copies the model into a new snapshot and publishes it. The copy is a
+// clone, so attribute ids in the snapshot match the model's.
+void UMLSharedModel::publish ()
+{
+  auto snapshot = std::make_shared<Snapshot>();
+  // The model and the snapshot readers see are the same size, and the
+  // history measures its own snapshots as it takes them
+  size_t modelBytes = data.getFootprint().getTotalBytes();
+  historyBytes = history.snapshot_bytes();
+  bytes = 2 * modelBytes + historyBytes;
+  undos = history.undo_size();
+  static UMLHistogram& entryBytes = UMLMetrics::global().histogram ("uml_history_entry_bytes",
+    "Size of the model as of each commit, which each history entry keeps", "", UMLMetrics::SIZE_BUCKETS);
+  entryBytes.observe (modelBytes);
+  snapshot->data = data.clone();
+  snapshot->version = modelVersion;
+  std::atomic_store (&current, std::shared_ptr<const Snapshot> (std::move (snapshot)));
+}
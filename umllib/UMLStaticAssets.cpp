@@ -0,0 +1,136 @@
+/*
+  Filename   : UMLStaticAssets.cpp
+  Description: Implementation of the static file cache.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLStaticAssets.hpp"
+#include "include/UMLCompression.hpp"
+#include "include/UMLEmbeddedFiles.hpp"
+#include "include/UMLPageCache.hpp"
+
+#include <fstream>
+#include <sstream>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+namespace fs = std::filesystem;
+//--------------------------------------------------------------------
+
+// Constructor: dev mode reads from disk under root and rechecks files on
+// every lookup
+UMLStaticAssets::UMLStaticAssets(bool newDevMode, const string& newRoot)
+:root(newRoot), devMode(newDevMode)
+{
+}
+
+// Loads every file in a directory, compressing each once up front. Embedded
+// copies are used unless in dev mode or none were embedded.
+void UMLStaticAssets::load(const string& newDirectory)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  directory = root / newDirectory;
+  assets.clear();
+  if (!devMode)
+  {
+    string prefix = newDirectory + "/";
+    for (const UMLEmbeddedFile& file : UMLEmbeddedFiles::all())
+    {
+      string name = file.name;
+      if (name.compare(0, prefix.size(), prefix) != 0)
+        continue;
+      auto asset = make(name, file.contents(), file.etag);
+      // Can't change while the program runs
+      asset->cacheControl = "public, max-age=300";
+      assets[name.substr(prefix.size())] = asset;
+    }
+    if (!assets.empty())
+      return;
+  }
+
+  std::error_code error;
+  for (const auto& entry : fs::directory_iterator(directory, error))
+  {
+    if (!entry.is_regular_file(error))
+      continue;
+    auto asset = read(entry.path());
+    if (asset)
+      assets[entry.path().filename().string()] = asset;
+  }
+}
+
+// Returns the named file, or null if there is no such file. Only files
+// found by load are served, so a name can't reach outside the directory.
+std::shared_ptr<const UMLAsset> UMLStaticAssets::find(const string& name)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = assets.find(name);
+  if (found == assets.end())
+    return nullptr;
+
+  if (devMode)
+  {
+    std::error_code error;
+    auto modified = fs::last_write_time(directory / name, error);
+    if (!error && modified != found->second->modified)
+    {
+      auto asset = read(directory / name);
+      if (asset)
+        found->second = asset;
+    }
+  }
+  return found->second;
+}
+
+// Returns the content type for a file name's extension
+string UMLStaticAssets::contentType(const string& name)
+{
+  static const std::map<string, string> types = {
+    {".css", "text/css"},
+    {".html", "text/html"},
+    {".js", "application/javascript"},
+    {".json", "application/json"},
+    {".png", "image/png"},
+    {".svg", "image/svg+xml"},
+    {".txt", "text/plain"}
+  };
+  auto found = types.find(fs::path(name).extension().string());
+  return found == types.end() ? "application/octet-stream" : found->second;
+}
+
+// Reads and compresses a single file, returns null if it can't be read
+std::shared_ptr<const UMLAsset> UMLStaticAssets::read(const fs::path& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return nullptr;
+  std::ostringstream contents;
+  contents << file.rdbuf();
+
+  string body = contents.str();
+  string etag = UMLPageCache::makeETag(0, body);
+  auto asset = make(path.filename().string(), std::move(body), std::move(etag));
+  std::error_code error;
+  asset->modified = fs::last_write_time(path, error);
+  // May be edited on disk, so clients check back every time
+  asset->cacheControl = "no-cache";
+  return asset;
+}
+
+// Prepares a file's contents for sending, compressing them if it helps
+std::shared_ptr<UMLAsset> UMLStaticAssets::make(const string& name, string body, string etag)
+{
+  auto asset = std::make_shared<UMLAsset>();
+  asset->type = contentType(name);
+  asset->body = std::move(body);
+  asset->etag = std::move(etag);
+  if (UMLCompression::isCompressible(asset->type) && asset->body.size() >= UMLCompression::MIN_SIZE)
+  {
+    string gzipped = UMLCompression::gzip(asset->body);
+    if (gzipped.size() < asset->body.size())
+      asset->gzipped = std::move(gzipped);
+  }
+  return asset;
+}
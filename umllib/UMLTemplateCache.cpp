@@ -0,0 +1,89 @@
+/*
+  Filename   : UMLTemplateCache.cpp
+  Description: Implementation of the template cache.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLTemplateCache.hpp"
+#include "include/UMLEmbeddedFiles.hpp"
+#include "include/UMLMetrics.hpp"
+#include "include/UMLTrace.hpp"
+//--------------------------------------------------------------------
+
+// Constructor: dev mode reads templates from disk under root, and rechecks
+// their files on every lookup
+UMLTemplateCache::UMLTemplateCache(bool newDevMode, const string& newRoot)
+:devMode(newDevMode), root(newRoot)
+{
+}
+
+// Parses a template ahead of time so the first request doesn't pay for it
+void UMLTemplateCache::load(const string& path)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  parse(path);
+}
+
+// Returns the parsed template, parsing it if it hasn't been yet
+std::shared_ptr<const inja::Template> UMLTemplateCache::get(const string& path)
+{
+  return lookup(path).parsed;
+}
+
+// Renders a cached template with the given data. The template and its
+// environment are held by shared pointer, so a dev mode reload swaps in
+// new ones rather than changing these under the render.
+string UMLTemplateCache::render(const string& path, const json& data)
+{
+  static UMLHistogram& renderTime = UMLMetrics::global().histogram("uml_template_render_seconds",
+    "Time taken to render page templates");
+  UMLTimer timer(renderTime);
+  UML_TRACE_SCOPE("UMLTemplateCache::render");
+  Entry entry = lookup(path);
+  return entry.env->render(*entry.parsed, data);
+}
+
+// Returns the entry for a template, parsing it if it hasn't been yet or,
+// in dev mode, if its file changed
+UMLTemplateCache::Entry UMLTemplateCache::lookup(const string& path)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = templates.find(path);
+  if (found == templates.end())
+    return parse(path);
+
+  if (devMode)
+  {
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(root + path, error);
+    if (!error && modified != found->second.modified)
+      return parse(path);
+  }
+  return found->second;
+}
+
+// Turns file change checking on or off
+void UMLTemplateCache::setDevMode(bool enabled)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  devMode = enabled;
+}
+
+// Parses the template at path and stores it. The embedded copy is used
+// unless in dev mode or the template wasn't embedded.
+UMLTemplateCache::Entry& UMLTemplateCache::parse(const string& path)
+{
+  Entry entry;
+  entry.env = std::make_shared<inja::Environment>();
+  const UMLEmbeddedFile* file = devMode ? nullptr : UMLEmbeddedFiles::find(path);
+  if (file)
+    entry.parsed = std::make_shared<const inja::Template>(entry.env->parse(file->contents()));
+  else
+  {
+    std::error_code error;
+    entry.modified = std::filesystem::last_write_time(root + path, error);
+    entry.parsed = std::make_shared<const inja::Template>(entry.env->parse_template(root + path));
+  }
+  return templates[path] = entry;
+}
@@ -0,0 +1,138 @@
+/*
+  Filename   : UMLTrace.cpp
+  Description: Implementation of the per-thread span trace.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "include/UMLTrace.hpp"
+//--------------------------------------------------------------------
+
+// Returns true if the program was built with UML_TRACING
+bool UMLTrace::enabled()
+{
+#ifdef UML_TRACING
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Returns nanoseconds since the trace started
+std::uint64_t UMLTrace::now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+// Returns the calling thread's buffer, reusing the oldest retired one or
+// creating one on first use. Only the first call on each thread takes the
+// lock.
+UMLTrace::Buffer& UMLTrace::local()
+{
+  thread_local Lease lease;
+  if (!lease.buffer)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (retired.empty())
+    {
+      buffers.push_back(std::make_shared<Buffer>());
+      lease.buffer = buffers.back();
+    }
+    else
+    {
+      lease.buffer = retired.front();
+      retired.pop_front();
+      lease.buffer->written.store(0, std::memory_order_release);
+    }
+    lease.buffer->thread.store(++threads, std::memory_order_relaxed);
+  }
+  return *lease.buffer;
+}
+
+// Retires the exiting thread's buffer. Its spans stay in dumps until a new
+// thread takes it over.
+UMLTrace::Lease::~Lease()
+{
+  if (!buffer)
+    return;
+  UMLTrace& trace = UMLTrace::global();
+  std::lock_guard<std::mutex> guard(trace.lock);
+  trace.retired.push_back(std::move(buffer));
+}
+
+// Records a finished span for the calling thread, overwriting its oldest
+// span once the buffer is full
+void UMLTrace::record(const char* name, std::uint64_t start, std::uint64_t end)
+{
+  Buffer& buffer = local();
+  std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+  Buffer::Span& span = buffer.spans[index % CAPACITY];
+  span.name.store(name, std::memory_order_relaxed);
+  span.start.store(start, std::memory_order_relaxed);
+  span.duration.store(end - start, std::memory_order_relaxed);
+  buffer.written.store(index + 1, std::memory_order_release);
+}
+
+// Returns the spans still held, as Chrome trace_event JSON. A thread may
+// overwrite spans while they are copied; those are dropped afterwards.
+json UMLTrace::dump()
+{
+  std::vector<std::shared_ptr<Buffer>> threads;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    threads = buffers;
+  }
+
+  json events = json::array();
+  for (const std::shared_ptr<Buffer>& buffer : threads)
+  {
+    std::uint64_t end = buffer->written.load(std::memory_order_acquire);
+    std::uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    json spans = json::array();
+    for (std::uint64_t i = begin; i < end; ++i)
+    {
+      const Buffer::Span& span = buffer->spans[i % CAPACITY];
+      spans += {
+        {"name", span.name.load(std::memory_order_relaxed)},
+        {"ph", "X"},
+        {"ts", span.start.load(std::memory_order_relaxed) / 1000.0},
+        {"dur", span.duration.load(std::memory_order_relaxed) / 1000.0},
+        {"pid", 1},
+        {"tid", buffer->thread.load(std::memory_order_relaxed)}
+      };
+    }
+    // Anything the thread wrapped around to while copying may be torn
+    std::uint64_t after = buffer->written.load(std::memory_order_acquire);
+    size_t overwritten = after > begin + CAPACITY ? after - begin - CAPACITY : 0;
+    for (size_t i = overwritten; i < spans.size(); ++i)
+      events += std::move(spans[i]);
+  }
+  return {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+}
+
+// Returns how many buffers are held, in use or retired
+size_t UMLTrace::bufferCount()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return buffers.size();
+}
+
+// Trace the program's spans are recorded to
+UMLTrace& UMLTrace::global()
+{
+  static UMLTrace trace;
+  return trace;
+}
+
+// Constructor: starts the span
+UMLTraceScope::UMLTraceScope(const char* newName)
+:name(newName), start(UMLTrace::global().now())
+{
+}
+
+// Destructor: records the span
+UMLTraceScope::~UMLTraceScope()
+{
+  UMLTrace& trace = UMLTrace::global();
+  trace.record(name, start, trace.now());
+}
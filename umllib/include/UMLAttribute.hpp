@@ -9,6 +9,7 @@
 //--------------------------------------------------------------------
 // System includes
 #include <string>
+#include <memory>
 //--------------------------------------------------------------------
 
 //--------------------------------------------------------------------
@@ -25,6 +26,9 @@ class UMLAttribute
 		// Type of attribute
 		string type;
 
+		// Identifies the attribute within its class, 0 until it is added to one
+		unsigned long id = 0;
+
 	public:
 		// OLD Constructor for attribute objects without a type
 		UMLAttribute(string newName);
@@ -33,17 +37,26 @@ class UMLAttribute
 		UMLAttribute(string newName, string newType);
 
 		// Grab name of the given attribute
-		string getAttributeName() const;
+		const string& getAttributeName() const;
 
 		// Change name of the given attribute
 		void changeName(string newName);
 
 		// Grab type of the given attribute
-		string getType() const;
+		const string& getType() const;
 
 		// Change type of the given attribute
 		void changeType(string newType);
         
 		// Placeholder to identifiy what type an attribute is
 		virtual string identifier() const;
+
+		// Grab the id of the given attribute
+		unsigned long getId() const;
+
+		// Set the id of the given attribute, done by the class holding it
+		void setId(unsigned long newId);
+
+		// Returns a separate copy of the attribute, id included
+		virtual std::shared_ptr<UMLAttribute> clone() const;
 };
\ No newline at end of file
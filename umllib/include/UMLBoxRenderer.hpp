@@ -0,0 +1,70 @@
+#pragma once
+/*
+  Filename   : UMLBoxRenderer.hpp
+  Description: Draws classes, methods and relationships as the text boxes
+  the CLI shows. Everything is rendered into one buffer that is reused
+  between calls and written out with a single flush.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "UMLClass.hpp"
+#include "UMLMethod.hpp"
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using std::vector;
+//--------------------------------------------------------------------
+
+class UMLBoxRenderer
+{
+  private:
+    // Output waiting to be flushed
+    string buffer;
+
+    // Content lines of the class being drawn, laid end to end, and the
+    // offset each one ends at
+    string lines;
+    vector<size_t> lineEnds;
+
+    // Overload numbers of the class being drawn
+    vector<int> numbers;
+
+    // Appends "name(p : type, ...) : type [number]" for a method
+    static void appendSignature(string& out, const UMLMethod& method, int number);
+
+    // Appends a box row holding the given text, padded to the width
+    void appendRow(const char* text, size_t length, size_t width);
+
+    // Appends the edge of a box of the given width
+    void appendEdge(size_t width);
+
+  public:
+    // Overload number of each of the class's attributes, in order. Methods
+    // are numbered from 1 among the methods sharing their name, fields get 0.
+    static vector<int> overloadNumbers(const UMLClass& uclass);
+
+    // Draws a class as a box of its name, fields and methods
+    void renderClass(const UMLClass& uclass);
+
+    // Draws a single method line with its overload number
+    void renderMethod(const UMLMethod& method, int number);
+
+    // Draws a relationship's type followed by the boxes of both classes
+    void renderRelationship(const UMLClass& source, const UMLClass& destination, const string& type);
+
+    // Adds text as is
+    void append(const string& text);
+
+    // Writes everything rendered so far and empties the buffer
+    void flush(std::ostream& out);
+
+    // Everything rendered since the last flush
+    const string& str() const;
+};
@@ -15,10 +15,12 @@
 #include <fstream>
 #include "UMLClass.hpp"
 #include "UMLAttribute.hpp"
+#include "UMLBoxRenderer.hpp"
 #include "UMLRelationship.hpp"
 #include "UMLData.hpp"
 #include "UMLDataHistory.hpp"
 #include "UMLFile.hpp"
+#include "UMLListFilter.hpp"
 #include "UMLMethod.hpp"
 #include "UMLField.hpp"
 #include "UMLParameter.hpp"
@@ -70,6 +72,20 @@ class UMLCLI
     // Allows for undo/redo
     UMLDataHistory History {Model};
 
+    // Set when the running command fails, for script results
+    bool CommandFailed = false;
+
+    // Scripts take history snapshots only when an undo or redo needs one,
+    // rather than after every edit
+    bool BatchHistory = false;
+    bool HistoryPending = false;
+
+    // Builds the output of the display functions, reused between commands
+    UMLBoxRenderer Renderer;
+
+    // Listings write out what they've rendered once it reaches this size
+    static const size_t LIST_FLUSH_SIZE = 1 << 16;
+
     /********************/
     //Adding
 
@@ -103,9 +119,18 @@ class UMLCLI
     /********************/
     //Display functions
 
-    void display_class(UMLClass currentClass);
-    void display_method(string className, method_ptr methodIter); 
-    void display_relationship(UMLClass source, UMLClass destination, string rType);
+    void display_class(const UMLClass& currentClass);
+    void display_method(const string& className, method_ptr methodIter); 
+    void display_relationship(const UMLClass& source, const UMLClass& destination, const string& rType);
+
+    /********************/
+    //Listing
+
+    // Parses listing options, printing the problem if they aren't valid
+    bool parse_list_filter(const vector<string>& options, UMLListSubject subject, std::unique_ptr<UMLListFilter>& filter);
+
+    // Adds the line below a listing saying which page was shown
+    void list_footer(const UMLListFilter& filter, size_t matched, const string& things);
 
     /********************/
     //Undo/Redo
@@ -113,6 +138,13 @@ class UMLCLI
     void undo();
     void redo();
 
+    // Snapshots the model after an edit, or marks it for the next snapshot
+    // when batching
+    void save_history();
+
+    // Takes the snapshot a batch of edits is waiting on
+    void flush_history();
+
     /********************/
     //Misc.
     
@@ -124,7 +156,7 @@ class UMLCLI
     void clear_selected_method();
 
     // Overload handlers
-    int method_number(string className, method_ptr method);
+    int method_number(const string& className, method_ptr method);
     method_ptr select_overload(string className, string methodName, int overloadNumber);
     
 
@@ -137,11 +169,21 @@ class UMLCLI
     // Begins a CLI for use in main.
     void start();
 
-    // Lists all classes the user has created.
-    void list_classes();
+    // Runs commands from a stream without prompts, writing a line of json
+    // for each. Returns the number of commands that failed.
+    int run_script(std::istream& in, std::ostream& out);
+
+    // Lists the classes the user has created, filtered and paged by the
+    // options.
+    void list_classes(const vector<string>& options = {});
+
+    // Lists the relationships the user has created, filtered and paged by
+    // the options.
+    void list_relationships(const vector<string>& options = {});
 
-    // Lists all relationships the user has created.
-    void list_relationships();
+    // Shows how much memory the diagram and its undo history take up,
+    // and where it goes.
+    void show_stats();
 
     // User creates and names a class and may give it any number
     // of attributes.
@@ -0,0 +1,58 @@
+#pragma once
+/*
+  Filename   : UMLChangeFeed.hpp
+  Description: Keeps the most recent model changes in order of version
+  so that clients can stream them, or catch up after reconnecting.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+//--------------------------------------------------------------------
+
+class UMLChangeFeed
+{
+  public:
+    // A single change, payload is already serialized json
+    struct Event
+    {
+      unsigned long version;
+      string payload;
+    };
+
+  private:
+    // Most recent events, oldest first
+    std::deque<Event> events;
+    size_t capacity;
+
+    // Version of the newest event published
+    unsigned long latestVersion = 0;
+
+    std::mutex lock;
+    std::condition_variable published;
+
+  public:
+    // Constructor: takes in how many events are kept for resuming clients
+    UMLChangeFeed(size_t capacity = 1024);
+
+    // Adds an event and wakes every waiting reader
+    void publish(unsigned long version, string payload);
+
+    // Collects events newer than version into out, waiting up to timeout for
+    // one to arrive. Returns false if events after version were already
+    // dropped, meaning the caller has to reload the whole model.
+    bool waitSince(unsigned long version, std::chrono::milliseconds timeout, std::vector<Event>& out);
+
+    // Returns the version of the newest event published
+    unsigned long latest();
+};
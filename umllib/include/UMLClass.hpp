@@ -12,6 +12,7 @@
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include <unordered_map>
 #include "UMLAttribute.hpp"
 #include "UMLParameter.hpp"
 //--------------------------------------------------------------------
@@ -31,12 +32,30 @@ class UMLClass
 		int x = 1000;
 		int y = 350;
 
+		// Attribute id to its slot in classAttributes, and the next id to hand out
+		std::unordered_map<unsigned long, size_t> attributeSlots;
+		unsigned long nextAttributeId = 1;
+
+		// Method ids of each method name, in the order the methods appear in
+		// classAttributes, and each method's overload number among them
+		std::unordered_map<string, vector<unsigned long>> overloads;
+		std::unordered_map<unsigned long, int> overloadNumbers;
+
+		// Updates the slots of attributes at or after the given position
+		void updateSlots(size_t from);
+
+		// Adds a method to the overloads of its name, in attribute order
+		void addOverload(const UMLAttribute& method);
+
+		// Removes a method from the overloads of its name
+		void removeOverload(const UMLAttribute& method);
+
 	public:
 		// Constructor for class object without attributes
 		UMLClass(string newClass);
 
 		// Grab name from given class object
-		string getName() const;
+		const string& getName() const;
 
 		// Change name of given class object
 		void changeName(string newClassName);
@@ -69,8 +88,18 @@ class UMLClass
 		// OLD Finds attribute within pointer vector, returns smart pointer
 		std::shared_ptr<UMLAttribute> getAttribute(string attributeName);
 
+		// Finds attribute by its id, throws if the class has no such attribute
+		std::shared_ptr<UMLAttribute> getAttributeById(unsigned long id) const;
+
+		// Overload number of a method among the methods sharing its name,
+		// counting from 1. Returns 0 if the class has no such method.
+		int getOverloadNumber(const UMLAttribute& method) const;
+
+		// Method with the given name and overload number, or nullptr
+		std::shared_ptr<UMLAttribute> getOverload(const string& methodName, int number) const;
+
 		// Returns vector pointer of attributes 
-		vector<std::shared_ptr<UMLAttribute>> getAttributes() const;
+		const vector<std::shared_ptr<UMLAttribute>>& getAttributes() const;
 
 		// Sets the x value
 		void setX(int val);
@@ -79,10 +108,10 @@ class UMLClass
 		void setY(int val);
 
 		// Gets the x value
-		int getX();
+		int getX() const;
 
 		// Gets the y value
-		int getY();
+		int getY() const;
 
 		// Operator that allows for two UMLClasses to be tested as equal
 		bool operator==(const UMLClass& other) const {return (this->getName() == other.getName());}
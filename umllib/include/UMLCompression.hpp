@@ -0,0 +1,36 @@
+#pragma once
+/*
+  Filename   : UMLCompression.hpp
+  Description: Gzip compression of server responses, and the
+  Accept-Encoding negotiation that decides when to use it.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+//--------------------------------------------------------------------
+
+class UMLCompression
+{
+  public:
+    // Bodies smaller than this are sent as they are, compressing them
+    // saves less than the header it costs
+    static const size_t MIN_SIZE = 1024;
+
+    // Compresses data into the gzip format
+    static string gzip(const string& data);
+
+    // Decompresses gzip data, throws if it is not valid
+    static string gunzip(const string& data);
+
+    // Checks an Accept-Encoding header value for gzip
+    static bool acceptsGzip(const string& acceptEncoding);
+
+    // Returns true for content types that are worth compressing
+    static bool isCompressible(const string& type);
+};
@@ -9,7 +9,9 @@
 // System includes
 #include "UMLClass.hpp"
 #include "UMLAttribute.hpp"
+#include "UMLFootprint.hpp"
 #include "UMLMethod.hpp"
+#include "UMLNameIndex.hpp"
 #include "UMLRelationship.hpp"
 #include <vector>
 #include <iostream>
@@ -64,6 +66,16 @@ class UMLData
     list<UMLClass> classes;
     vector<UMLRelationship> relationships;
 
+    // Class, attribute and type names, kept in step with the classes
+    UMLNameIndex names;
+
+    // Number of relationships of each type
+    size_t relationshipTypeCounts[none + 1] = {};
+
+    // Memory taken up by the classes and their attributes, kept in step
+    // with them
+    UMLFootprint footprint;
+
   public: 
 
     /********************************/
@@ -80,10 +92,10 @@ class UMLData
     // Get Collections
 
     // Returns vector of all classes
-    list<UMLClass> getClasses() const;
+    const list<UMLClass>& getClasses() const;
 
     // Returns vector of all relationships
-    vector<UMLRelationship> getRelationships() const;
+    const vector<UMLRelationship>& getRelationships() const;
     
     // Takes in className string and returns a vector of all the relationships associated with that class
     vector<UMLRelationship> getRelationshipsByClass(string className);
@@ -101,12 +113,25 @@ class UMLData
     // Gets relationship reference for the given string class names
     UMLRelationship& getRelationship(string srcName, string destName);
 
-    // Generates json file given a set of data
-    json getJson();
+    // Generates json file given a set of data, with each attribute's id if
+    // withIds is set
+    json getJson(bool withIds = false) const;
+
+    // Returns a copy sharing nothing with this one, attribute ids included
+    UMLData clone() const;
 
     // Returns string representation of relationship type
     string getRelationshipType(const string& srcName, const string& destName);
 
+    // Returns the index of names used in the model
+    const UMLNameIndex& getNameIndex() const;
+
+    // Returns the number of relationships of the given type
+    size_t countRelationships(Type type) const;
+
+    // Returns how much memory the model takes up and where it goes
+    UMLFootprint getFootprint() const;
+
 
     /********************************/
     // Adding
@@ -216,4 +241,8 @@ class UMLData
     // Takes in relationship object and adds it to relationship vector
     void addRelationship(const UMLRelationship& relationshipIn);
 
+    // Adds or drops the names and types an attribute uses in the name index
+    void indexAttribute(const UMLAttribute& attribute);
+    void unindexAttribute(const UMLAttribute& attribute);
+
 };
\ No newline at end of file
@@ -23,6 +23,16 @@ class UMLDataHistory
         std::stack<json> redos;
         json current;
 
+        // Estimated bytes of each snapshot, alongside the snapshots, and of
+        // all of them together
+        std::stack<size_t> undoBytes;
+        std::stack<size_t> redoBytes;
+        size_t currentBytes = 0;
+        size_t totalBytes = 0;
+
+        // Drops the newest redo snapshot
+        void pop_redo();
+
     public: 
         // Constructor that adds the originator to the history
         UMLDataHistory(UMLData& data);
@@ -48,6 +58,13 @@ class UMLDataHistory
         // Returns size of redo stack
         size_t redo_size();
 
-        //loads current json as UMLData
+        // Returns the estimated bytes held by every snapshot, current included
+        size_t snapshot_bytes() const;
+
+        //loads current json as UMLData, attribute ids included
         UMLData load_current();
+        // Returns the current snapshot and both stacks, oldest first
+        json getJson();
+        // Replaces the whole history with one returned by getJson
+        void setJson(const json& j);
 };
\ No newline at end of file
@@ -0,0 +1,190 @@
+#pragma once
+/*
+  Filename   : UMLDocumentStore.hpp
+  Description: Holds the documents served by the GUI and the state of
+  each browser session using them. Every document has its own model,
+  writer and change feed, so edits to different documents run in
+  parallel. Idle documents are written to disk when memory runs short or
+  too many are open, and idle sessions are forgotten.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "UMLChangeFeed.hpp"
+#include "UMLPageCache.hpp"
+#include "UMLSharedModel.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+// A named diagram along with everything derived from it
+struct UMLDocument
+{
+  // Name the document is opened by
+  const string name;
+
+  // Recent changes streamed to subscribed browsers
+  UMLChangeFeed feed;
+
+  // Model being edited, its history and version
+  UMLSharedModel model;
+
+  // Rendered pages keyed by model version and view state
+  UMLPageCache pages;
+
+  // Constructor: takes in the document's name, and the state its model
+  // returned when it was last closed, if any
+  UMLDocument (const string& name, const json& state = json());
+};
+
+// What one browser is looking at, and messages waiting to be shown to it
+struct UMLSession
+{
+  // View for focusing certain elements in sidebar
+  json view = {{"object", "all"}, {"name", ""}, {"name2", ""}};
+
+  // One-shot messages shown on the next page render
+  json errors = json::array();
+  json success = json::array();
+
+  // Guards the members above, never held while waiting on a model
+  std::mutex lock;
+};
+
+class UMLDocumentStore
+{
+  private:
+    // A resident document and its place in the recency list
+    struct Entry
+    {
+      std::shared_ptr<UMLDocument> document;
+      std::list<string>::iterator recent;
+    };
+
+    // A session, when it was last used and its place in the recency list
+    struct SessionEntry
+    {
+      std::shared_ptr<UMLSession> session;
+      std::chrono::steady_clock::time_point used;
+      std::list<string>::iterator recent;
+    };
+
+    // Documents held in memory, and their names most recently used first
+    std::map<string, Entry> documents;
+    std::list<string> recency;
+
+    // Documents being read back from disk or written out to it, both done
+    // outside the lock. Requests for them wait on settled rather than
+    // touching the file while another request is.
+    std::set<string> loading;
+    std::set<string> spooling;
+    std::condition_variable settled;
+
+    // Sessions, and their ids most recently used first
+    std::map<string, SessionEntry> sessions;
+    std::list<string> sessionRecency;
+
+    // Where evicted documents are written
+    std::filesystem::path spoolDirectory;
+
+    // Estimated bytes resident documents may use before idle ones are evicted
+    size_t budget;
+
+    // Most documents held in memory at once, each has its own writer thread
+    size_t maxDocuments;
+
+    // Most sessions kept, and how long an unused one is kept for
+    size_t maxSessions;
+    std::chrono::steady_clock::duration sessionTimeout;
+
+    // Counters reported by metrics
+    unsigned long evictions = 0;
+    unsigned long rehydrations = 0;
+    unsigned long quarantined = 0;
+    double lastRehydrateMilliseconds = 0;
+    double totalRehydrateMilliseconds = 0;
+
+    // Guards everything above. Files are read and written without it, the
+    // loading and spooling sets keep requests away from those documents.
+    std::mutex lock;
+
+    // Path an evicted document is written to
+    std::filesystem::path spoolPath (const string& name) const;
+
+    // Loads an evicted document back into memory, or null if there is none
+    // or its file could not be read. Runs without the lock.
+    std::shared_ptr<UMLDocument> rehydrate (const string& name, bool& corrupt);
+
+    // Closes evicted documents and writes them to disk, keeping any that
+    // could not be written. Called without the lock.
+    void spool (const std::vector<std::shared_ptr<UMLDocument>>& victims);
+
+    // Takes idle documents out of memory, least recently used first, until
+    // under budget with room for incoming more documents. Returns them for
+    // spool to write once the lock is released.
+    std::vector<std::shared_ptr<UMLDocument>> evict (const string& keep, size_t incoming = 0);
+
+    // Forgets sessions unused for longer than the timeout, and the least
+    // recently used ones past the limit
+    void expireSessions (std::chrono::steady_clock::time_point now);
+
+  public:
+    // Document opened when none is named
+    static const string DEFAULT_DOCUMENT;
+
+    // Memory budget used when none is given
+    static const size_t DEFAULT_BUDGET;
+
+    // Limits on documents in memory and on sessions used when none are given
+    static const size_t DEFAULT_MAX_DOCUMENTS;
+    static const size_t DEFAULT_MAX_SESSIONS;
+    static const std::chrono::steady_clock::duration DEFAULT_SESSION_TIMEOUT;
+
+    // Constructor: takes in where to write evicted documents, how many bytes
+    // resident documents may use, how many may be resident, and how many
+    // sessions are kept and for how long
+    UMLDocumentStore (const string& spoolDirectory = "documents", size_t budget = DEFAULT_BUDGET,
+      size_t maxDocuments = DEFAULT_MAX_DOCUMENTS, size_t maxSessions = DEFAULT_MAX_SESSIONS,
+      std::chrono::steady_clock::duration sessionTimeout = DEFAULT_SESSION_TIMEOUT);
+
+    // Returns the named document, loading it from disk if it was evicted or
+    // creating an empty one if it is new. Throws if too many documents are
+    // in use to make room for it.
+    std::shared_ptr<UMLDocument> document (const string& name);
+
+    // Returns the session with the given id, creating it if it is new or
+    // has expired
+    std::shared_ptr<UMLSession> session (const string& id);
+
+    // Returns the names of every document, resident or evicted
+    json listDocuments ();
+
+    // Returns residency, eviction and rehydration figures
+    json metrics ();
+
+    // Returns the documents currently held in memory
+    std::vector<std::shared_ptr<UMLDocument>> residentDocuments ();
+
+    // Returns true if name can be used for a document
+    static bool isValidName (const string& name);
+
+    // Creates a random, unguessable session id
+    static string newSessionId ();
+};
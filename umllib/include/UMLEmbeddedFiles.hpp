@@ -0,0 +1,40 @@
+#pragma once
+/*
+  Filename   : UMLEmbeddedFiles.hpp
+  Description: Static files and templates compiled into the program. The
+  table itself is generated at build time by cmake/EmbedFiles.cmake.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <vector>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+//--------------------------------------------------------------------
+
+// A file's contents, named by its path from the repository root. The ETag
+// is worked out from the contents when the table is generated.
+struct UMLEmbeddedFile
+{
+  const char* name;
+  const unsigned char* data;
+  size_t size;
+  const char* etag;
+
+  // Copies the contents out as a string
+  string contents() const;
+};
+
+class UMLEmbeddedFiles
+{
+  public:
+    // Every embedded file, defined in the generated source
+    static const std::vector<UMLEmbeddedFile>& all();
+
+    // Finds a file by its path from the repository root, null if it wasn't embedded
+    static const UMLEmbeddedFile* find(const string& name);
+};
@@ -29,4 +29,7 @@ class UMLField : public UMLAttribute
 
 		// Identifies this attribute as a field
 		string identifier() const;
+
+		// Returns a separate copy of the field, id included
+		std::shared_ptr<UMLAttribute> clone() const;
 };
@@ -46,6 +46,9 @@ class UMLFile
         // Makes a list of all JSON files in the build directory that can be used for loading.
         static json listSaves();
 
+        // Lists the saves in the build directory with their size, class count, and modification time.
+        static json listSaveInfo();
+
         // Gets the classes from the json file and adds them to the UMLData object
         static void addClasses(UMLData& data, const json& j);
         
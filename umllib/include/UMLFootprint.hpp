@@ -0,0 +1,118 @@
+#pragma once
+/*
+  Filename   : UMLFootprint.hpp
+  Description: Running estimate of the memory a diagram takes up and
+  where it goes. UMLData updates one as the model changes, so reading it
+  never walks the model. Sizes are estimated from the objects' layouts
+  and string lengths, as a typical 64-bit allocator would hand them out.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <cstddef>
+#include <string>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+class UMLClass;
+class UMLAttribute;
+class UMLParameter;
+
+class UMLFootprint
+{
+  private:
+    // Number of each kind of object in the model
+    size_t classCount = 0;
+    size_t fieldCount = 0;
+    size_t methodCount = 0;
+    size_t parameterCount = 0;
+    size_t relationshipCount = 0;
+
+    // Bytes held by each kind of object. Strings are counted apart, and
+    // only for what they keep on the heap.
+    size_t stringBytes = 0;
+    size_t classBytes = 0;
+    size_t attributeBytes = 0;
+    size_t parameterBytes = 0;
+    size_t indexBytes = 0;
+
+    // Slots reserved in the relationship vector, used or not
+    size_t relationshipCapacity = 0;
+
+    // Heap blocks behind everything above but the relationship vector
+    size_t allocations = 0;
+
+    // Name index bytes and blocks, filled in when the footprint is read
+    size_t nameIndexBytes = 0;
+    size_t nameIndexAllocations = 0;
+
+    // Counts or drops the heap bytes of a string
+    void addString(const string& text);
+    void removeString(const string& text);
+
+  public:
+    // Bookkeeping bytes a typical allocator adds to every block
+    static const size_t ALLOCATION_OVERHEAD = 16;
+
+    // Bytes of a std::map node besides its value: colour, parent and
+    // children
+    static const size_t MAP_NODE_BYTES = 4 * sizeof(void*);
+
+    // Heap bytes of a string, 0 when it fits in the string itself
+    static size_t heapBytes(const string& text);
+
+    // Estimated bytes of a json value and everything it holds, allocator
+    // overhead included
+    static size_t jsonBytes(const json& value);
+
+    // Counts or drops a class, without its attributes
+    void addClass(const UMLClass& uclass);
+    void removeClass(const UMLClass& uclass);
+
+    // Counts or drops an attribute, along with a method's parameters
+    void addAttribute(const UMLAttribute& attribute);
+    void removeAttribute(const UMLAttribute& attribute);
+
+    // Counts or drops a method's parameter
+    void addParameter(const UMLParameter& param);
+    void removeParameter(const UMLParameter& param);
+
+    // Swaps the bytes of one stored name for another
+    void rename(const string& oldName, const string& newName);
+
+    // Records how many relationships there are and how many the vector
+    // has room for
+    void setRelationships(size_t count, size_t capacity);
+
+    // Records what the name index takes up
+    void setNameIndex(size_t bytes, size_t blocks);
+
+    // Bytes of each part of the model
+    size_t getStringBytes() const;
+    size_t getClassBytes() const;
+    size_t getAttributeBytes() const;
+    size_t getParameterBytes() const;
+    size_t getRelationshipBytes() const;
+    size_t getIndexBytes() const;
+    size_t getOverheadBytes() const;
+
+    // Bytes of the whole model
+    size_t getTotalBytes() const;
+
+    // Counts of each kind of object
+    size_t getClassCount() const;
+    size_t getFieldCount() const;
+    size_t getMethodCount() const;
+    size_t getParameterCount() const;
+    size_t getRelationshipCount() const;
+
+    // Counts and bytes as json, for the stats command and endpoint
+    json toJson() const;
+};
@@ -0,0 +1,96 @@
+#pragma once
+/*
+  Filename   : UMLGenerator.hpp
+  Description: Generates large synthetic diagrams from a seed, so that
+  performance work can be repeated on the same model. The same options
+  always give the same diagram.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <vector>
+#include <ostream>
+#include <random>
+#include <functional>
+
+#include <nlohmann/json.hpp>
+
+#include "UMLData.hpp"
+#include "UMLRelationship.hpp"
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using std::vector;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+// How the classes of a generated diagram are related
+enum class UMLGraphShape
+{
+  // Every class but the first generalizes one earlier class
+  tree,
+  // Every class relates to degree earlier classes picked evenly
+  dense,
+  // Every class relates to degree earlier classes, picked in proportion to
+  // how related they already are, so a few classes become hubs
+  scaleFree
+};
+
+// Settings for a generated diagram. Ranges are inclusive, each class's
+// counts are drawn evenly from them.
+struct UMLGeneratorOptions
+{
+  unsigned long long seed = 1;
+  size_t classes = 100;
+  size_t minFields = 0;
+  size_t maxFields = 6;
+  size_t minMethods = 0;
+  size_t maxMethods = 6;
+  size_t minParams = 0;
+  size_t maxParams = 3;
+  // Chance that a method overloads one of its class's earlier methods
+  double overloadDensity = 0.1;
+  // Number of type names used by fields, return types and parameters
+  size_t typeCount = 12;
+  UMLGraphShape shape = UMLGraphShape::tree;
+  // Relationships each class starts, for dense and scale-free graphs
+  size_t degree = 3;
+};
+
+class UMLGenerator
+{
+  private:
+    UMLGeneratorOptions options;
+
+    // Type names to draw from, built in types first
+    vector<string> types;
+
+    // Makes the i'th class in the format of UMLData::getJson
+    json makeClass(size_t index, std::mt19937_64& random) const;
+
+    // Makes a method's parameters
+    json makeParams(size_t count, std::mt19937_64& random) const;
+
+    // Calls back with every relationship's source, destination and type
+    void eachRelationship(const std::function<void (size_t, size_t, Type)>& callback) const;
+
+    // Name of the i'th class
+    static string className(size_t index);
+
+  public:
+    // Constructor: throws if the options are out of range
+    UMLGenerator(const UMLGeneratorOptions& options);
+
+    // Builds the diagram as a model. Adding to UMLData checks every name,
+    // so use write for the largest diagrams.
+    UMLData generate() const;
+
+    // Writes the diagram as a save without holding it in memory
+    void write(std::ostream& out) const;
+
+    // Reads "tree", "dense" or "scale-free"
+    static UMLGraphShape shapeFromString(const string& shape);
+};
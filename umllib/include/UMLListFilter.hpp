@@ -0,0 +1,88 @@
+#pragma once
+/*
+  Filename   : UMLListFilter.hpp
+  Description: Options for the CLI's class and relationship listings.
+  Picks out which classes or relationships to list, which page of them
+  to show, and counts them from the model's indexes where it can.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <vector>
+
+#include "UMLClass.hpp"
+#include "UMLData.hpp"
+#include "UMLRelationship.hpp"
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using std::vector;
+//--------------------------------------------------------------------
+
+// What a listing lists, since each takes different filters
+enum class UMLListSubject
+{
+  classes,
+  relationships
+};
+
+class UMLListFilter
+{
+  private:
+    // Class name to match, a prefix unless it has glob wildcards in it.
+    // Relationships match if either of their classes does.
+    string name;
+    bool glob = false;
+
+    // Type a class's field or method must have, empty for any
+    string memberType;
+
+    // Relationship type to match, none for any
+    Type relationshipType = none;
+
+    // Page to show counting from 1, and its size. A size of 0 shows all.
+    size_t page = 1;
+    size_t pageSize = 0;
+
+    // Only the number of matches is wanted
+    bool countOnly = false;
+
+    // Returns true if the class name matches the name filter
+    bool matchesName(const string& className) const;
+
+  public:
+    // Rows per page when a page is asked for without a size
+    static const size_t DEFAULT_PAGE_SIZE = 50;
+
+    // Constructor: parses options such as "--name Shape*" or "--page 2",
+    // throws on options that aren't valid for the subject
+    UMLListFilter(const vector<string>& options, UMLListSubject subject);
+
+    // Returns true if the class or relationship passes every filter
+    bool matches(const UMLClass& uclass) const;
+    bool matches(const UMLRelationship& relationship) const;
+
+    // Returns true if nothing is filtered out
+    bool unfiltered() const;
+
+    // Returns true if only the number of matches is wanted
+    bool counting() const;
+
+    // Returns true if a single page was asked for
+    bool paged() const;
+
+    // Positions among the matches of the first and one past the last row
+    // of the page
+    size_t pageStart() const;
+    size_t pageEnd() const;
+
+    // Number of matching classes or relationships
+    size_t countClasses(const UMLData& data) const;
+    size_t countRelationships(const UMLData& data) const;
+
+    // Returns true if the text matches a pattern of * and ? wildcards
+    static bool globMatch(const string& pattern, const string& text);
+};
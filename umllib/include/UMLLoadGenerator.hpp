@@ -0,0 +1,84 @@
+#pragma once
+/*
+  Filename   : UMLLoadGenerator.hpp
+  Description: Drives a mixed workload of page renders, saves, drags and
+  edits against a running UMLServer, and reports throughput and latency
+  percentiles for each route.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using std::vector;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+// Settings for a load run
+struct UMLLoadOptions
+{
+  string host = "localhost";
+  int port = 60555;
+  // Connections sending requests at once
+  size_t workers = 4;
+  // Requests sent across all workers
+  size_t requests = 2000;
+  // Requests per second across all workers for an open loop, where
+  // requests are sent on a schedule whether or not earlier ones have been
+  // answered. Zero is a closed loop, each worker waits for its answer.
+  double rate = 0;
+  // The same seed sends the same requests in the same order
+  unsigned long long seed = 1;
+  // Document the requests edit, kept apart from the user's
+  string document = "loadtest";
+};
+
+// A single request of the workload
+struct UMLLoadRequest
+{
+  // Name latencies are reported under
+  string route;
+  string path;
+};
+
+class UMLLoadGenerator
+{
+  private:
+    UMLLoadOptions options;
+
+    // Latencies in seconds and error count of one route
+    struct RouteResults
+    {
+      vector<double> latencies;
+      size_t errors = 0;
+    };
+
+    // Sends a worker's requests, adding to its own results
+    void runWorker(size_t worker, std::chrono::steady_clock::time_point start,
+      std::map<string, RouteResults>& results) const;
+
+    // Times at which an open loop worker sends each request, from the start
+    vector<double> schedule(size_t worker, size_t count) const;
+
+  public:
+    // Constructor: throws if the options are out of range
+    UMLLoadGenerator(const UMLLoadOptions& options);
+
+    // Requests a worker sends, in order
+    vector<UMLLoadRequest> plan(size_t worker) const;
+
+    // Sends every worker's requests and returns the report
+    json run() const;
+
+    // Value below which the fraction p of sorted values fall
+    static double percentile(const vector<double>& sorted, double p);
+};
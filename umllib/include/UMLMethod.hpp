@@ -33,7 +33,7 @@ class UMLMethod : public UMLAttribute
 		UMLMethod(string newName, string newType, std::list<UMLParameter> newParam);
 
 		// Returns a list of all of the method's parameters
-		std::list<UMLParameter> getParam();
+		const std::list<UMLParameter>& getParam() const;
 
 		// Changes the list of the method's parameters to match the parameter
 		void setParam(std::list<UMLParameter> newParam);
@@ -44,6 +44,9 @@ class UMLMethod : public UMLAttribute
 		// Identifies this attribute as a method
 		string identifier() const;
 
+		// Returns a separate copy of the method, id and parameters included
+		std::shared_ptr<UMLAttribute> clone() const;
+
 		// Deletes a parameter from the given name
 		void deleteParameter(string name);
 
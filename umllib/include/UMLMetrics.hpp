@@ -0,0 +1,155 @@
+#pragma once
+/*
+  Filename   : UMLMetrics.hpp
+  Description: Counters, gauges and histograms reported by the server's
+  /metrics route in Prometheus' text format. Metrics are registered once,
+  after which recording a value is a few relaxed atomic operations.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+//--------------------------------------------------------------------
+
+// A value that only goes up
+class UMLCounter
+{
+  private:
+    std::atomic<unsigned long> value {0};
+
+  public:
+    // Adds to the count
+    void add(unsigned long amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+
+    // Returns the count
+    unsigned long get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// A value that is set to whatever it currently is
+class UMLGauge
+{
+  private:
+    std::atomic<double> value {0};
+
+  public:
+    // Replaces the value
+    void set(double newValue) { value.store(newValue, std::memory_order_relaxed); }
+
+    // Returns the value
+    double get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Counts observations into buckets by upper bound, along with their sum
+class UMLHistogram
+{
+  private:
+    const std::vector<double> bounds;
+
+    // One count per bound plus one for everything above the last
+    std::unique_ptr<std::atomic<unsigned long>[]> buckets;
+    std::atomic<unsigned long> count {0};
+    std::atomic<double> sum {0};
+
+  public:
+    // Constructor: takes in the upper bounds of the buckets, ascending
+    UMLHistogram(const std::vector<double>& bounds);
+
+    // Records a value
+    void observe(double value);
+
+    // Returns the number of values recorded
+    unsigned long getCount() const;
+
+    // Returns the sum of the values recorded
+    double getSum() const;
+
+    // Returns the upper bounds and how many values fell at or under each
+    std::vector<std::pair<double, unsigned long>> cumulative() const;
+};
+
+// Records the seconds from its construction to its destruction
+class UMLTimer
+{
+  private:
+    UMLHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+
+  public:
+    // Constructor: starts timing into histogram
+    UMLTimer(UMLHistogram& histogram);
+
+    // Destructor: records the elapsed time
+    ~UMLTimer();
+};
+
+class UMLMetrics
+{
+  private:
+    // Metrics sharing a name, one per set of labels
+    struct Family
+    {
+      string help;
+      string type;
+      std::map<string, UMLCounter*> counters;
+      std::map<string, UMLGauge*> gauges;
+      std::map<string, UMLHistogram*> histograms;
+    };
+
+    // Families by name. Metrics are never removed, and deques don't move
+    // their elements, so references handed out stay good.
+    std::map<string, Family> families;
+    std::deque<UMLCounter> counters;
+    std::deque<UMLGauge> gauges;
+    std::deque<UMLHistogram> histograms;
+
+    // Guards registration and reporting, never taken to record a value
+    std::mutex lock;
+
+    // Finds or adds a family, throws if it was registered as another type
+    Family& family(const string& name, const string& help, const string& type);
+
+  public:
+    // Upper bounds in seconds used for timings
+    static const std::vector<double> LATENCY_BUCKETS;
+
+    // Upper bounds used for sizes in bytes
+    static const std::vector<double> SIZE_BUCKETS;
+
+    // Registers a counter, or returns the one already registered. Labels
+    // are written the Prometheus way, e.g. route="/",method="GET"
+    UMLCounter& counter(const string& name, const string& help, const string& labels = "");
+
+    // Registers a gauge, or returns the one already registered
+    UMLGauge& gauge(const string& name, const string& help, const string& labels = "");
+
+    // Registers a histogram, or returns the one already registered
+    UMLHistogram& histogram(const string& name, const string& help, const string& labels = "",
+      const std::vector<double>& bounds = LATENCY_BUCKETS);
+
+    // Writes every metric in Prometheus' text format
+    string exposition();
+
+    // Writes a single sample line in Prometheus' text format
+    static string sample(const string& name, const string& labels, double value);
+
+    // Formats a number for the text format
+    static string number(double value);
+
+    // Quotes a label value, escaping what the text format requires
+    static string label(const string& value);
+
+    // Registry the program's metrics are kept in
+    static UMLMetrics& global();
+};
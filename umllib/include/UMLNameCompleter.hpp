@@ -0,0 +1,53 @@
+#pragma once
+/*
+  Filename   : UMLNameCompleter.hpp
+  Description: Tab completion for the arguments of a menu's commands. The
+  cli library only completes command names, so one of these is inserted
+  into each menu as a command that never runs, and answers completion
+  requests for the commands it was given.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <cli/cli.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <ostream>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using std::vector;
+//--------------------------------------------------------------------
+
+class UMLNameCompleter : public cli::Command
+{
+  public:
+    // Completes one argument. Given the arguments typed before it and the
+    // start of this one, returns whole values the argument could take.
+    using Source = std::function<vector<string>(const vector<string>& previous, const string& prefix)>;
+
+  private:
+    // Sources for each argument of each command, empty where there's
+    // nothing to complete
+    std::map<string, vector<Source>> commands;
+
+  public:
+    // Constructor: completes nothing until commands are added
+    UMLNameCompleter();
+
+    // Completes the arguments of a command with the given sources
+    void add(const string& command, vector<Source> arguments);
+
+    // Never handles a command, they're left to the menu's other commands
+    bool Exec(const vector<string>& cmdLine, cli::CliSession& session) override;
+
+    // Not a command of its own, so has no help
+    void Help(std::ostream& out) const override;
+
+    // Completions for a line of the menu, as whole lines
+    vector<string> GetCompletionRecursive(const string& line) const override;
+};
@@ -0,0 +1,80 @@
+#pragma once
+/*
+  Filename   : UMLNameIndex.hpp
+  Description: Sorted index of the names used in a diagram, so names can
+  be completed from a prefix without searching the whole model. UMLData
+  keeps one up to date as the model changes.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <vector>
+#include <map>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using std::vector;
+//--------------------------------------------------------------------
+
+// Kinds of names kept apart in the index
+enum class UMLNameKind
+{
+  className,
+  field,
+  method,
+  // Field types, method return types and parameter types
+  type
+};
+
+class UMLNameIndex
+{
+  private:
+    // Number of kinds, for sizing the name maps
+    static const size_t KIND_COUNT = 4;
+
+    // Each name and how many places in the model use it, for every kind.
+    // Many classes can share a field name or type, so names are counted and
+    // only leave the index once the last use is gone.
+    std::map<string, size_t> names[KIND_COUNT];
+
+    // Bytes and heap blocks held by the maps' nodes, kept as names come
+    // and go
+    size_t nodeBytes = 0;
+    size_t nodeBlocks = 0;
+
+    // Counts or drops the memory of a name's node
+    void addNode(const string& name);
+    void removeNode(const string& name);
+
+  public:
+    // Completions handed back when no limit is given
+    static const size_t DEFAULT_LIMIT = 64;
+
+    // Counts a use of the name
+    void add(UMLNameKind kind, const string& name);
+
+    // Drops a use of the name, removing it after its last use
+    void remove(UMLNameKind kind, const string& name);
+
+    // Swaps one use of a name for another
+    void rename(UMLNameKind kind, const string& oldName, const string& newName);
+
+    // Names of the kind starting with the prefix, in sorted order
+    vector<string> complete(UMLNameKind kind, const string& prefix, size_t limit = DEFAULT_LIMIT) const;
+
+    // Number of distinct names of the kind starting with the prefix
+    size_t count(UMLNameKind kind, const string& prefix) const;
+
+    // Returns true if some part of the model uses the name
+    bool contains(UMLNameKind kind, const string& name) const;
+
+    // Number of distinct names of the kind
+    size_t size(UMLNameKind kind) const;
+
+    // Bytes and heap blocks the index takes up
+    size_t bytes() const;
+    size_t allocations() const;
+};
@@ -0,0 +1,57 @@
+#pragma once
+/*
+  Filename   : UMLPageCache.hpp
+  Description: Holds rendered pages for the GUI keyed by the model
+  version they were rendered from, along with their ETags. Only the
+  latest render of each page is kept.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+//--------------------------------------------------------------------
+
+// A rendered page and the validator sent along with it. Large pages also
+// keep a gzip copy, empty for small ones.
+struct UMLPage
+{
+  unsigned long version;
+  // Save listing generation, for pages that list the saves
+  unsigned long generation;
+  string body;
+  string etag;
+  string gzipped;
+};
+
+class UMLPageCache
+{
+  private:
+    // Page key (route plus view state) to the last page rendered for it
+    std::map<string, std::shared_ptr<const UMLPage>> pages;
+    std::mutex lock;
+
+  public:
+    // Returns the cached page for key if it was rendered at version and
+    // generation, otherwise null
+    std::shared_ptr<const UMLPage> find(const string& key, unsigned long version, unsigned long generation = 0);
+
+    // Stores a freshly rendered page, replacing any older version of it
+    std::shared_ptr<const UMLPage> store(const string& key, unsigned long version, string body, unsigned long generation = 0);
+
+    // Drops every cached page
+    void clear();
+
+    // Creates a strong ETag from the page's version and contents
+    static string makeETag(unsigned long version, const string& body);
+
+    // Checks an If-None-Match header value against an ETag
+    static bool matches(const string& ifNoneMatch, const string& etag);
+};
@@ -26,13 +26,13 @@ class UMLParameter
 		UMLParameter(string name, string type);
 
 		// Grab name of the given parameter
-		string getName() const;
+		const string& getName() const;
 
 		// Change name of the given parameter
 		void changeName(string newName);
 
 		// Grab type of the given parameter
-		string getType() const;
+		const string& getType() const;
 
 		// Change type of the given parameter
 		void changeType(string newType);
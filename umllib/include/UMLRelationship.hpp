@@ -45,6 +45,9 @@ class UMLRelationship
 		// Converts inserted string to proper type enum
 		static Type string_to_type(const std::string&);
 
+		// Converts type enum to its string name
+		static std::string type_to_string(Type);
+
 		// Set type of relationship
 		void setType(int newType);
 
@@ -0,0 +1,113 @@
+#pragma once
+/*
+  Filename   : UMLSaveCatalog.hpp
+  Description: Keeps an in-memory listing of the JSON saves within a
+  directory, so that pages can list saves without scanning the disk.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+class UMLSaveCatalog
+{
+  private:
+    // Information kept about a single save file
+    struct SaveInfo
+    {
+      std::uintmax_t size = 0;
+      size_t classCount = 0;
+      std::filesystem::file_time_type modified;
+
+      bool operator==(const SaveInfo& other) const;
+    };
+
+    // Directory being catalogued and its last seen modification time
+    std::filesystem::path directory;
+    std::filesystem::file_time_type directoryModified;
+    bool stale = true;
+
+    // When the directory was last looked at, it is statted at most once
+    // per interval however often the listings are read
+    std::chrono::steady_clock::time_point lastChecked;
+
+    // Bumped every time the listings change
+    unsigned long listingGeneration = 0;
+
+    // Save name (no extension) to file information
+    std::map<string, SaveInfo> saves;
+
+    // Cached listings handed out to callers, replaced rather than changed
+    std::shared_ptr<const json> names = std::make_shared<const json>(json::array());
+    std::shared_ptr<const json> details = std::make_shared<const json>(json::array());
+
+    // Guards all of the above, the server reads from many threads
+    std::mutex lock;
+
+    // Rebuilds the catalog from the directory if it changed
+    void refresh();
+
+    // Re-reads a single entry, returns false if the path is not a save
+    bool updateEntry(const std::filesystem::path& path);
+
+    // Regenerates the cached json listings from the save map
+    void rebuildListings();
+
+    // Returns true if the path looks like a loadable save
+    static bool isSave(const std::filesystem::path& path);
+
+    // Returns true if something could still change without the
+    // modification time moving on from this one
+    static bool isRecent(std::filesystem::file_time_type modified);
+
+    // Reads the class count out of a save's header
+    static size_t readClassCount(const std::filesystem::path& path);
+
+  public:
+    // Names of the saves along with the generation they were listed at
+    struct Listing
+    {
+      std::shared_ptr<const json> names;
+      unsigned long generation;
+    };
+
+    // Constructor: takes in the directory to catalog
+    UMLSaveCatalog(const string& directory = ".");
+
+    // Returns the names (no extension) of all saves in the directory
+    json listSaves();
+
+    // Returns name, size, class count, and modification time for each save
+    json listSaveInfo();
+
+    // Returns a counter that changes whenever the listings change
+    unsigned long generation();
+
+    // Returns the names of all saves and their generation in one go
+    Listing listing();
+
+    // Updates a single file after it has been written. Saves changed
+    // some other way are picked up once the directory's time moves, or
+    // after invalidate().
+    void touch(const string& path);
+
+    // Forces a full rescan on the next listing
+    void invalidate();
+
+    // Catalog of the working directory shared by UMLFile
+    static UMLSaveCatalog& working();
+};
@@ -0,0 +1,53 @@
+#pragma once
+/*
+  Filename   : UMLSaveWriter.hpp
+  Description: Writes a save one class and relationship at a time, so
+  models too large to hold as a single json can still be saved. The
+  output is what UMLFile::load reads.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <ostream>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+class UMLSaveWriter
+{
+  private:
+    std::ostream& out;
+
+    // Classes promised up front, since the header leads the file
+    size_t classCount;
+    size_t classesWritten = 0;
+    size_t relationshipsWritten = 0;
+    bool finished = false;
+
+    // Closes the class list and opens the relationship list
+    void endClasses();
+
+  public:
+    // Constructor: writes the header, which needs the number of classes
+    UMLSaveWriter(std::ostream& out, size_t classCount);
+
+    // Writes a class in the format of UMLData::getJson
+    void addClass(const json& uclass);
+
+    // Writes a relationship, all classes must have been written first
+    void addRelationship(const json& relationship);
+
+    // Closes the save, throws if fewer classes were written than promised
+    void finish();
+
+    // Number of classes and relationships written so far
+    size_t classes() const;
+    size_t relationships() const;
+};
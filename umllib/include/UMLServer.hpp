@@ -7,6 +7,12 @@
 //--------------------------------------------------------------------
 // System includes
 #include "UMLData.hpp"
+#include "UMLDocumentStore.hpp"
+#include "UMLStaticAssets.hpp"
+#include "UMLTemplateCache.hpp"
+#include <functional>
+#include <memory>
+#include <httplib.h>
 #include <nlohmann/json.hpp>
 //--------------------------------------------------------------------
 
@@ -19,16 +25,67 @@ using json = nlohmann::json;
 class UMLServer
 {
   private:
+    // Handles a request to a route
+    using Handler = std::function<void (const httplib::Request&, httplib::Response&)>;
 
-    // No private methods
+    // Document and session a page request works with
+    struct Context
+    {
+      std::shared_ptr<UMLDocument> document;
+      std::shared_ptr<UMLSession> session;
+    };
+
+    // Every open document and browser session
+    UMLDocumentStore store;
+
+    // Parsed page templates, shared by every request
+    UMLTemplateCache templates;
+
+    // Static files for the GUI, held in memory with gzip copies
+    UMLStaticAssets assets;
+
+    // JSON API routes that answer with changed entities
+    void addApiRoutes (httplib::Server& svr);
+
+    // Registers a handler whose requests are counted and timed under its pattern
+    void route (httplib::Server& svr, const std::string& method, const std::string& pattern, Handler handler);
+
+    // Writes every metric in Prometheus' text format, for /metrics
+    std::string metricsText ();
+
+    // Finds the document a request names with ?doc=, or its cookie
+    std::shared_ptr<UMLDocument> documentFor (const httplib::Request& req);
+
+    // Finds the document and session of a page request, setting cookies
+    // for a new session or a newly chosen document
+    Context open (const httplib::Request& req, httplib::Response& res);
+
+    // Runs a page route edit, recording its error for the next render
+    void pageEdit (Context& context, const UMLSharedModel::Edit& edit);
+
+    // Delta holding the whole model
+    static json fullDelta (const UMLData& data);
 
   public:
+    // Constructor: dev mode reads templates and static files from disk, and
+    // reloads them when they change
+    UMLServer(bool devMode = false);
+
     // Controller management for the GUI
     void start (int port);
     
-    // Attribute index management
-    void addAttributeIndexes (json& j, const UMLData& data);
+    // Serializes the model with each attribute's id, in one pass
+    static json indexedJson (const UMLData& data);
 
     // Loads json into UMLData
-    UMLData load_json(json j);
-};
\ No newline at end of file
+    static UMLData load_json(json j);
+
+    // Applies a list of batch operations as one unit, see /api/v1/batch
+    static json applyBatch (UMLData& data, const json& operations);
+
+    // Serializes a class for the API, including attribute ids
+    static json classJson (const UMLClass& uclass);
+
+    // Serializes a relationship for the API
+    static json relationshipJson (const UMLRelationship& relationship);
+};
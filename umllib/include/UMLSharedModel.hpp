@@ -0,0 +1,149 @@
+#pragma once
+/*
+  Filename   : UMLSharedModel.hpp
+  Description: Owns the model edited by the server. A single writer
+  thread applies queued edits in order, and after each batch publishes
+  an immutable snapshot that request threads read without waiting on
+  the writer.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include "UMLData.hpp"
+#include "UMLDataHistory.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+class UMLSharedModel
+{
+  public:
+    // An edit changes the model and returns a delta describing the change
+    using Edit = std::function<json (UMLData&)>;
+
+    // Called with each committed delta, in version order, once readers can
+    // see the change
+    using Listener = std::function<void (unsigned long, const json&)>;
+
+  private:
+    // Immutable view of the model handed to readers
+    struct Snapshot
+    {
+      unsigned long version = 0;
+      UMLData data;
+    };
+
+    // Queued work for the writer, run against the model and its history
+    struct Command
+    {
+      std::function<json (UMLData&, UMLDataHistory&)> run;
+      // False for undo and redo, which move through the history themselves
+      bool recorded = true;
+      std::promise<json> done;
+    };
+
+    // Only touched by the writer thread
+    UMLData data;
+    UMLDataHistory history {data};
+    unsigned long modelVersion = 0;
+
+    // Notified of each commit
+    Listener listener;
+
+    // Estimated bytes held by the model and its history, and how many
+    // steps can be undone
+    std::atomic<size_t> bytes {0};
+    std::atomic<size_t> undos {0};
+
+    // Estimated bytes held by the history's snapshots
+    std::atomic<size_t> historyBytes {0};
+
+    // Latest published snapshot, swapped atomically
+    std::shared_ptr<const Snapshot> current;
+
+    // Commands waiting for the writer
+    std::vector<std::unique_ptr<Command>> queue;
+    bool stopping = false;
+    std::mutex queueLock;
+    std::condition_variable queued;
+
+    std::thread writer;
+
+    // Queues a command and waits for the writer to finish it. A recorded
+    // command's result is saved into the history once it commits.
+    json submit (std::function<json (UMLData&, UMLDataHistory&)> run, bool recorded = true);
+
+    // Writer loop: drains the queue a batch at a time
+    void writeLoop ();
+
+    // Copies the model into a new snapshot and publishes it
+    void publish ();
+
+    // Finishes queued commands and joins the writer
+    void stop ();
+
+  public:
+    // Constructor: starts the writer, listener is told about every commit.
+    // A state returned by close picks the model up where it left off.
+    UMLSharedModel (Listener listener = nullptr, const json& state = json());
+
+    // Destructor: finishes queued commands and stops the writer
+    ~UMLSharedModel ();
+
+    UMLSharedModel (const UMLSharedModel&) = delete;
+    UMLSharedModel& operator= (const UMLSharedModel&) = delete;
+
+    // Runs reader against the latest snapshot and its version, and returns
+    // whatever it returns. Never waits on the writer.
+    template <typename Reader>
+    auto read (Reader reader) const
+    {
+      std::shared_ptr<const Snapshot> snapshot = std::atomic_load (&current);
+      return reader (snapshot->data, snapshot->version);
+    }
+
+    // Queues edit for the writer and waits for it to be committed. An edit
+    // returning null changed nothing and is not committed. If edit throws
+    // whatever it changed is rolled back and the exception is passed on. Edits must not
+    // call write themselves.
+    json write (const Edit& edit);
+
+    // Steps back through history, describe builds the delta of the result.
+    // Returns null, and commits nothing, if there is nothing to undo.
+    json undo (const Edit& describe);
+
+    // Steps forward through history, describe builds the delta of the result.
+    // Returns null, and commits nothing, if there is nothing to redo.
+    json redo (const Edit& describe);
+
+    // Returns the version of the latest snapshot
+    unsigned long version () const;
+
+    // Returns roughly how many bytes the model and its history take up
+    size_t footprint () const;
+
+    // Returns how many steps can be undone
+    size_t undoDepth () const;
+
+    // Returns roughly how many bytes the history's snapshots take up
+    size_t historyFootprint () const;
+
+    // Stops the writer and returns the version and history, from which a
+    // new model can be constructed. Readers may still use the last
+    // snapshot, but the model can't be written to afterwards.
+    json close ();
+};
@@ -0,0 +1,69 @@
+#pragma once
+/*
+  Filename   : UMLStaticAssets.hpp
+  Description: Holds the GUI's static files in memory, each with a gzip
+  copy made once when it is loaded rather than on every request. Files
+  come from the program itself, or from disk in dev mode.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+//--------------------------------------------------------------------
+
+// A static file ready to send. gzipped is empty when compressing the
+// file would not make it smaller.
+struct UMLAsset
+{
+  string type;
+  string body;
+  string gzipped;
+  string etag;
+  string cacheControl;
+  std::filesystem::file_time_type modified;
+};
+
+class UMLStaticAssets
+{
+  private:
+    // Directory that disk paths are relative to, and the one loaded
+    std::filesystem::path root;
+    std::filesystem::path directory;
+
+    // File name to its loaded contents
+    std::map<string, std::shared_ptr<const UMLAsset>> assets;
+    std::mutex lock;
+
+    // Reload files that changed since they were read
+    bool devMode;
+
+    // Reads and compresses a single file, returns null if it can't be read
+    std::shared_ptr<const UMLAsset> read(const std::filesystem::path& path);
+
+    // Prepares a file's contents for sending
+    static std::shared_ptr<UMLAsset> make(const string& name, string body, string etag);
+
+  public:
+    // Constructor: dev mode reads from disk under root and rechecks files
+    // on every lookup
+    UMLStaticAssets(bool devMode = false, const string& root = "");
+
+    // Loads every file in a directory, given relative to the repository
+    // root. Uses the embedded copies unless in dev mode or none were embedded.
+    void load(const string& directory);
+
+    // Returns the named file, or null if there is no such file
+    std::shared_ptr<const UMLAsset> find(const string& name);
+
+    // Returns the content type for a file name's extension
+    static string contentType(const string& name);
+};
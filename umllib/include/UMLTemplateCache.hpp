@@ -0,0 +1,73 @@
+#pragma once
+/*
+  Filename   : UMLTemplateCache.hpp
+  Description: Parses the GUI's inja templates once and hands out the
+  compiled templates for every render afterwards. Templates come from the
+  program itself, or from disk in dev mode.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+
+#include <inja/inja.hpp>
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+class UMLTemplateCache
+{
+  private:
+    // A parsed template, the environment it was parsed in and the
+    // modification time of its source. Each template gets its own
+    // environment, since parsing writes to it and renders read from it, so
+    // a dev mode reload never touches one a render is using.
+    struct Entry
+    {
+      std::shared_ptr<inja::Environment> env;
+      std::shared_ptr<const inja::Template> parsed;
+      std::filesystem::file_time_type modified;
+    };
+
+    std::map<string, Entry> templates;
+    std::mutex lock;
+
+    // Read templates from disk and reload them when their file changes
+    bool devMode;
+
+    // Directory that template paths are relative to on disk
+    string root;
+
+    // Parses the template at path and stores it
+    Entry& parse(const string& path);
+
+    // Returns the entry for a template, parsing it if it hasn't been yet
+    Entry lookup(const string& path);
+
+  public:
+    // Constructor: dev mode reads templates from disk under root, and
+    // rechecks their files on every lookup
+    UMLTemplateCache(bool devMode = false, const string& root = "");
+
+    // Parses a template ahead of time so the first request doesn't pay for
+    // it. Paths are relative to the repository root.
+    void load(const string& path);
+
+    // Returns the parsed template, parsing it if it hasn't been yet
+    std::shared_ptr<const inja::Template> get(const string& path);
+
+    // Renders a cached template with the given data
+    string render(const string& path, const json& data);
+
+    // Turns file change checking on or off
+    void setDevMode(bool enabled);
+};
@@ -0,0 +1,123 @@
+#pragma once
+/*
+  Filename   : UMLTrace.hpp
+  Description: Scoped trace spans kept in a ring buffer per thread, and
+  dumped on demand as Chrome trace_event JSON (open it in
+  chrome://tracing or https://ui.perfetto.dev). Spans are only recorded
+  when built with UML_TRACING, otherwise UML_TRACE_SCOPE is nothing.
+*/
+
+//--------------------------------------------------------------------
+// System includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// Using declarations
+using std::string;
+using json = nlohmann::json;
+//--------------------------------------------------------------------
+
+// Records a span named name from here to the end of the enclosing scope.
+// name must outlive the trace, such as a string literal.
+#ifdef UML_TRACING
+#define UML_TRACE_JOIN_(a, b) a##b
+#define UML_TRACE_JOIN(a, b) UML_TRACE_JOIN_(a, b)
+#define UML_TRACE_SCOPE(name) UMLTraceScope UML_TRACE_JOIN(umlTraceScope, __LINE__) (name)
+#else
+#define UML_TRACE_SCOPE(name) ((void) 0)
+#endif
+
+class UMLTrace
+{
+  public:
+    // Spans kept per thread, older ones are overwritten
+    static const size_t CAPACITY = 16384;
+
+    // Spans recorded by one thread. Only that thread writes, dumps read
+    // from others, so the fields are atomics. A buffer is handed to a new
+    // thread once its thread has exited.
+    struct Buffer
+    {
+      struct Span
+      {
+        std::atomic<const char*> name {nullptr};
+        std::atomic<std::uint64_t> start {0};
+        std::atomic<std::uint64_t> duration {0};
+      };
+
+      std::atomic<unsigned long> thread {0};
+      std::atomic<std::uint64_t> written {0};
+      std::unique_ptr<Span[]> spans {new Span[CAPACITY]};
+    };
+
+  private:
+    // Held by each thread while it runs, gives the thread's buffer back to
+    // the trace when the thread exits
+    struct Lease
+    {
+      std::shared_ptr<Buffer> buffer;
+      ~Lease();
+    };
+
+    // Every buffer, so spans of exited threads still show up in a dump.
+    // Buffers of exited threads are retired, oldest first, and reused by
+    // new threads, so there are never more than the most threads that
+    // have run at once.
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    std::deque<std::shared_ptr<Buffer>> retired;
+    unsigned long threads = 0;
+    std::mutex lock;
+
+    // When the trace started, span times are relative to it
+    const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+    // Returns the calling thread's buffer, creating it on first use
+    Buffer& local();
+
+    // Only the global trace exists, threads find their buffer in it
+    UMLTrace() = default;
+
+  public:
+    // Returns true if the program was built with UML_TRACING
+    static bool enabled();
+
+    // Returns nanoseconds since the trace started
+    std::uint64_t now() const;
+
+    // Records a finished span for the calling thread
+    void record(const char* name, std::uint64_t start, std::uint64_t end);
+
+    // Returns the spans still held, as Chrome trace_event JSON
+    json dump();
+
+    // Returns how many buffers are held, in use or retired
+    size_t bufferCount();
+
+    // Trace the program's spans are recorded to
+    static UMLTrace& global();
+};
+
+// Records the time from its construction to its destruction, see UML_TRACE_SCOPE
+class UMLTraceScope
+{
+  private:
+    const char* name;
+    std::uint64_t start;
+
+  public:
+    // Constructor: starts the span
+    UMLTraceScope(const char* name);
+
+    // Destructor: records the span
+    ~UMLTraceScope();
+};